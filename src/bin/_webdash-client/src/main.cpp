@@ -3,9 +3,12 @@
 #include "../common/utils.hpp"
 
 // WebDash
+#include <webdash-child-supervisor.hpp>
 #include <webdash-config.hpp>
+#include <webdash-config-index.hpp>
 #include <webdash-core.hpp>
 #include <webdash-exceptions.hpp>
+#include <webdash-timing-history.hpp>
 
 // Standard
 #include <cstdio>
@@ -14,6 +17,7 @@
 #include <filesystem>
 #include <optional>
 #include <algorithm>
+#include <thread>
 
 // External
 #include <nlohmann/json.hpp>
@@ -55,10 +59,37 @@ namespace NATIVE_COMMANDS
     string RELOADALL = "reload-all";
     string HELP = "help";
     string LIST_CONFIG = "list-config";
+    string REINDEX = "reindex";
     string LIST_DEFINITIONS = "list-definitions";
     string _INT_CREATE_BUILD_INIT = _WEBDASH_INTERNAL_CMD_PREFIX + "create-build-init";
     string _INT_CREATE_PROJECT_CLONER = _WEBDASH_INTERNAL_CMD_PREFIX + "create-project-cloner";
     string PING_SERVER = "ping-server";
+    string STATS = "stats";
+};
+
+
+/**
+ * Options that apply to config-based commands. They are removed from the arguments before the commands are matched.
+ */
+struct ClientOptions {
+    // Maximum number of tasks executed at the same time (`-j N`, `-jN`, `--jobs=N`; `-j` alone uses all cores).
+    int concurrency = 1;
+
+    // Runs tasks declaring `inputs` even if their inputs did not change since their last run, and tasks with
+    // `frequency` or `when` even if they are not due (`--force`).
+    bool force = false;
+
+    // Runs tasks with `"cache": true` without looking up or storing their results in the action cache (`--no-cache`).
+    bool use_action_cache = true;
+
+    // Terminates the actions still running after this many seconds and starts no further ones (`--timeout=SECONDS`).
+    std::optional<double> timeout_seconds;
+
+    // Reads further targets from stdin, one per line (`--batch`).
+    bool batch = false;
+
+    // Prints the tasks that would be executed instead of executing them (`--plan`).
+    bool plan = false;
 };
 
 
@@ -72,10 +103,12 @@ vector<string> WebDashNativeCommands()
              NATIVE_COMMANDS::RELOADALL,
              NATIVE_COMMANDS::HELP,
              NATIVE_COMMANDS::LIST_CONFIG,
+             NATIVE_COMMANDS::REINDEX,
              NATIVE_COMMANDS::LIST_DEFINITIONS,
              NATIVE_COMMANDS::_INT_CREATE_BUILD_INIT,
              NATIVE_COMMANDS::_INT_CREATE_PROJECT_CLONER,
-             NATIVE_COMMANDS::PING_SERVER };
+             NATIVE_COMMANDS::PING_SERVER,
+             NATIVE_COMMANDS::STATS };
 }
 
 
@@ -96,7 +129,69 @@ bool IsInternalCommand(const string command) {
 
 
 /**
- * @brief Command: `webdash list-config`.
+ * @brief Parses the client options (see ClientOptions) and removes them from the given arguments.
+ * @param arguments The (command line) arguments. Recognized options are erased.
+ * @throws std::invalid_argument Thrown if an option has a malformed value.
+ * @returns The parsed options.
+ */
+ClientOptions ExtractClientOptions(vector<string>& arguments) {
+    ClientOptions options;
+    vector<string> remaining;
+
+    auto ParseConcurrency = [](const string& value) -> int {
+        size_t parsed_length = 0;
+        const int concurrency = stoi(value, &parsed_length);
+
+        if (parsed_length != value.size() || concurrency < 1)
+            throw std::invalid_argument("Invalid number of jobs: " + value);
+
+        return concurrency;
+    };
+
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        const string& argument = arguments[i];
+
+        if (argument == "-j") {
+            const bool has_value = i + 1 < arguments.size() && !arguments[i + 1].empty() &&
+                                   all_of(arguments[i + 1].begin(), arguments[i + 1].end(), ::isdigit);
+
+            if (has_value) {
+                options.concurrency = ParseConcurrency(arguments[++i]);
+            } else {
+                options.concurrency = max(1u, std::thread::hardware_concurrency());
+            }
+        } else if (argument.rfind("--jobs=", 0) == 0) {
+            options.concurrency = ParseConcurrency(argument.substr(7));
+        } else if (argument.size() > 2 && argument.rfind("-j", 0) == 0) {
+            options.concurrency = ParseConcurrency(argument.substr(2));
+        } else if (argument == "--force") {
+            options.force = true;
+        } else if (argument == "--no-cache") {
+            options.use_action_cache = false;
+        } else if (argument == "--batch") {
+            options.batch = true;
+        } else if (argument == "--plan") {
+            options.plan = true;
+        } else if (argument.rfind("--timeout=", 0) == 0) {
+            size_t parsed_length = 0;
+            const string value = argument.substr(10);
+            options.timeout_seconds = stod(value, &parsed_length);
+
+            if (parsed_length != value.size() || options.timeout_seconds.value() <= 0)
+                throw std::invalid_argument("Invalid timeout: " + value);
+        } else {
+            remaining.push_back(argument);
+        }
+    }
+
+    arguments = std::move(remaining);
+    return options;
+}
+
+
+/**
+ * @brief Command: `webdash list-config`. Lists the configs below the WebDash root from the WebDashConfigIndex, which
+ *        loads only the configs that are new or changed since they were indexed.
  * @param arguments The (command line) arguments.
  * @returns True if, based on the taken action, further execution should be terminated; false otherwise.
  */
@@ -107,7 +202,29 @@ bool ListRegistered_Command(const vector<string>& arguments) {
     if (arguments[0] != NATIVE_COMMANDS::LIST_CONFIG)
         return false;
 
-    WebDashConfigList();
+    for (const auto& entry : WebDashConfigIndex::Get().List()) {
+        cout << "   " << entry.config_path << " (" << entry.task_names.size() << " tasks)" << endl;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Command: `webdash reindex`. Rebuilds the WebDashConfigIndex by walking the WebDash root and loading every
+ *        config again.
+ * @param arguments The (command line) arguments.
+ * @returns True if, based on the taken action, further execution should be terminated; false otherwise.
+ */
+bool Reindex_Command(const vector<string>& arguments) {
+    if (arguments.size() != 1)
+        return false;
+
+    if (arguments[0] != NATIVE_COMMANDS::REINDEX)
+        return false;
+
+    const size_t config_count = WebDashConfigIndex::Get().Rebuild();
+    cout << "Indexed " << config_count << " configs." << endl;
 
     return true;
 }
@@ -380,17 +497,296 @@ bool ListDefinitions_Command(const vector<string>& arguments) {
 }
 
 
+/**
+ * @brief Prints the timing statistics of a task from the timing history.
+ *
+ *          `webdash stats <task>`
+ *
+ *          `webdash stats <path-to-config>:<task>`
+ *
+ * @param arguments The (command line) arguments.
+ * @returns True if, based on the taken action, further execution should be terminated; false otherwise.
+ */
+bool Stats_Command(const vector<string>& arguments) {
+
+    if (arguments.size() != 2)
+        return false;
+    if (arguments[0] != NATIVE_COMMANDS::STATS)
+        return false;
+
+    vector<string> adjusted_arguments(arguments.begin() + 1, arguments.end());
+
+    auto config_and_command = GetConfigAndCommand(adjusted_arguments);
+
+    if (!config_and_command)
+        return false;
+
+    auto task = config_and_command->first.GetTask(config_and_command->second);
+
+    if (!task) {
+        cout << "Unknown task: " << arguments[1] << endl;
+        return true;
+    }
+
+    const auto records = WebDashTimingHistory::Get().Read(task->GetTaskId());
+    const auto statistics = WebDashTimingHistory::ComputeStatistics(records);
+
+    auto seconds = [](std::chrono::microseconds duration) {
+        stringstream formatted;
+        formatted << fixed << setprecision(2) << duration.count() / 1e6 << "s";
+        return formatted.str();
+    };
+
+    const string indent(kSpaceOutGroup, ' ');
+
+    cout << task->GetTaskId() << endl;
+
+    if (statistics.run_count == 0) {
+        cout << indent << "No recorded runs." << endl;
+        return true;
+    }
+
+    cout << indent << "runs:    " << statistics.run_count << " (" << statistics.failure_count << " failed)" << endl;
+    cout << indent << "p50:     " << seconds(statistics.p50) << endl;
+    cout << indent << "p95:     " << seconds(statistics.p95) << endl;
+    cout << indent << "max:     " << seconds(statistics.max) << endl;
+    cout << indent << "max rss: " << statistics.max_rss_kb << " KiB" << endl;
+
+    if (statistics.trend.has_value()) {
+        const double change = (statistics.trend.value() - 1) * 100;
+        cout << indent << "trend:   " << showpos << fixed << setprecision(1) << change << noshowpos
+             << "% (median of the last " << WebDashTimingHistory::kTrendWindow << " runs vs. the "
+             << WebDashTimingHistory::kTrendWindow << " before)" << endl;
+    }
+
+    const auto& last = records.back();
+    const time_t last_start = last.start_unix_ms / 1000;
+    cout << indent << "last:    " << put_time(localtime(&last_start), "%Y-%m-%d %H:%M:%S")
+         << ", " << seconds(std::chrono::microseconds(last.duration_us)) << ", return code " << last.return_code << endl;
+
+    return true;
+}
+
+
+/**
+ * @brief Creates the execution parameters of config-based commands from the client options.
+ * @param options The client options.
+ * @returns The execution parameters.
+ */
+WebDashType::RunConfig CreateRunConfig(const ClientOptions& options) {
+    WebDashType::RunConfig runconfig;
+    runconfig.concurrency = options.concurrency;
+    runconfig.ignore_fingerprints = options.force;
+    runconfig.ignore_schedules = options.force;
+    runconfig.use_action_cache = options.use_action_cache;
+
+    if (options.timeout_seconds.has_value()) {
+        runconfig.deadline = std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(static_cast<long long>(options.timeout_seconds.value() * 1000));
+    }
+
+    return runconfig;
+}
+
+
+/**
+ * @brief Prints what running the targets would do (`--plan`): the dependency graph level by level (tasks of the same
+ *        level may run at the same time), the working directory and argv of each action, and the durations
+ *        estimated from previous runs. Nothing is executed.
+ * @param targets The targets to plan.
+ * @param options The client options the targets would be executed with.
+ */
+void PrintPlan(const vector<string>& targets, const ClientOptions& options) {
+    auto plan = PlanTargets(targets, CreateRunConfig(options));
+
+    if (!plan) {
+        cout << "No valid task found for all targets." << endl;
+        return;
+    }
+
+    if (!plan->acyclic) {
+        cout << "The dependency graph has a cycle (see above)." << endl;
+        return;
+    }
+
+    auto seconds = [](std::optional<std::chrono::milliseconds> duration) {
+        if (!duration) return string("?");
+
+        stringstream formatted;
+        formatted << fixed << setprecision(2) << duration->count() / 1e3 << "s";
+        return formatted.str();
+    };
+
+    const string indent(kSpaceOutGroup, ' ');
+    const string action_indent(kSpaceOutCommands, ' ');
+
+    auto print_task = [&](const WebDashType::PlannedTask& task, bool in_graph) {
+        cout << indent << task.taskid << "  ~" << seconds(task.estimated_duration);
+        if (in_graph) cout << " (critical path " << seconds(task.critical_path) << ")";
+        if (!task.skip_reason.empty()) cout << "  [skipped: " << task.skip_reason << "]";
+        cout << endl;
+
+        cout << action_indent << "wdir: " << task.wdir.value_or(fs::current_path().string()) << endl;
+
+        for (size_t i = 0; i < task.actions.size(); ++i) {
+            const auto& action = task.actions[i];
+
+            if (action.kind == WebDashType::CompiledAction::Kind::SubTask) {
+                const string& subtask_id = task.action_subtask_ids[i];
+                cout << action_indent << "sub-task: " << (subtask_id.empty() ? action.source + " (not found)" : subtask_id) << endl;
+                continue;
+            }
+
+            cout << action_indent << "argv: [";
+            for (size_t j = 0; j < action.argv->arguments.size(); ++j) {
+                cout << (j ? ", " : "") << "\"" << action.argv->arguments[j] << "\"";
+            }
+            cout << "]" << endl;
+        }
+    };
+
+    size_t level_count = 0;
+    size_t widest_level = 0;
+    std::chrono::milliseconds total_work{0};
+    std::chrono::milliseconds critical_path{0};
+    size_t unknown_count = 0;
+
+    for (size_t i = 0, level_size = 0; i < plan->tasks.size(); ++i) {
+        const auto& task = plan->tasks[i];
+
+        if (i == 0 || task.level != plan->tasks[i - 1].level) {
+            cout << "level " << task.level << ":" << endl;
+            level_count++;
+            level_size = 0;
+        }
+
+        print_task(task, true);
+
+        critical_path = max(critical_path, task.critical_path);
+
+        if (task.skip_reason.empty()) {
+            widest_level = max(widest_level, ++level_size);
+
+            if (task.estimated_duration) total_work += task.estimated_duration.value();
+            else unknown_count++;
+        }
+    }
+
+    if (!plan->subtasks.empty()) {
+        cout << "run in place as sub-tasks:" << endl;
+
+        for (const auto& task : plan->subtasks) {
+            print_task(task, false);
+        }
+    }
+
+    cout << "-----------------" << endl;
+    cout << plan->tasks.size() << " task(s) in " << level_count << " level(s); up to " << widest_level
+         << " can run at the same time (-j " << options.concurrency << ")." << endl;
+    cout << "Estimated: " << seconds(total_work) << " of work, " << seconds(critical_path) << " on the critical path";
+    if (unknown_count) cout << " (" << unknown_count << " task(s) without history)";
+    cout << "." << endl;
+}
+
+
+/**
+ * @brief Runs several targets in one process. Supported command types:
+ *
+ *           `webdash <target> <target> <target> ...`
+ *           `webdash <target> <path>:<target>`
+ *           `webdash <target> <target>`
+ *                Runs all given targets (e.g., `build`, `dir:test`, `dir/webdash.config.json:lint`). Two arguments are
+ *                `<path> <command>` instead if the first one is an existing file or directory and the second one has
+ *                no path (use `:<target>` to refer to a target of the current directory then).
+ *
+ *           `webdash --batch [<target> ...] < targets.txt`
+ *                Additionally runs the targets read from stdin, one per line. Empty lines and lines starting with
+ *                '#' are ignored.
+ *
+ *        All targets form a single dependency graph: configs are loaded once, shared dependencies run once and the
+ *        tasks of all targets share the `-j` workers.
+ *
+ * @param arguments The (command line) arguments.
+ * @param options The client options to execute the targets with.
+ * @param exit_status Set to 1 if a target failed, timed out or was cancelled, so that scripts can tell.
+ * @returns True if, based on the taken action, further execution should be terminated; false otherwise.
+ */
+bool MultiTarget_Command(const vector<string>& arguments, const ClientOptions& options, int& exit_status) {
+    // Two arguments are `<path> <command>` only if the first one exists and the second one has no path.
+    std::error_code ec;
+    const bool has_multiple_targets = arguments.size() >= 3 ||
+                                      (arguments.size() == 2 && (arguments[1].find(':') != string::npos ||
+                                                                 !fs::exists(arguments[0], ec)));
+
+    if (!options.batch && !has_multiple_targets)
+        return false;
+
+    vector<string> targets = arguments;
+
+    if (options.batch) {
+        string line;
+        while (getline(cin, line)) {
+            const size_t begin = line.find_first_not_of(" \t\r");
+            if (begin == string::npos || line[begin] == '#')
+                continue;
+
+            const size_t end = line.find_last_not_of(" \t\r");
+            targets.push_back(line.substr(begin, end - begin + 1));
+        }
+    }
+
+    if (targets.empty()) {
+        cout << "No targets given." << endl;
+        return true;
+    }
+
+    if (options.plan) {
+        PrintPlan(targets, options);
+        return true;
+    }
+
+    // Ctrl-C terminates the running actions together with everything they started.
+    WebDashChildSupervisor::InstallInterruptHandler();
+
+    auto ret = RunTargets(targets, CreateRunConfig(options));
+
+    cout << "-----------------" << endl;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (ret[i].return_code == 0 && !ret[i].timed_out && !ret[i].cancelled) {
+            cout << "  ok      " << targets[i] << endl;
+            continue;
+        }
+
+        cout << "  FAILED  " << targets[i] << " (return code " << ret[i].return_code
+             << (ret[i].timed_out ? ", timed out" : "") << (ret[i].cancelled ? ", cancelled" : "") << ")" << endl;
+        exit_status = 1;
+    }
+
+    return true;
+}
+
+
 /**
  * @brief Execute a command specified in a WebDash JSON configuration file.
+ * @param arguments The (command line) arguments.
+ * @param options The client options to execute the command with.
  * @returns True if, based on the taken action, further execution should be terminated; false otherwise.
  */
-bool ConfigBased_Command(const vector<string>& arguments) {
+bool ConfigBased_Command(const vector<string>& arguments, const ClientOptions& options) {
     auto config_and_command = GetConfigAndCommand(arguments);
 
     if (!config_and_command)
         return false;
 
-    auto ret = config_and_command->first.Run(config_and_command->second);
+    if (options.plan) {
+        PrintPlan({ config_and_command->first.GetPath() + ":" + config_and_command->second }, options);
+        return true;
+    }
+
+    // Ctrl-C terminates the running actions together with everything they started.
+    WebDashChildSupervisor::InstallInterruptHandler();
+
+    auto ret = config_and_command->first.Run(config_and_command->second, CreateRunConfig(options));
     if (!ret.empty())
         return true;
 
@@ -402,8 +798,9 @@ bool ConfigBased_Command(const vector<string>& arguments) {
  * @brief Takes a WebDash action based on the given arguments.
  * @param argc The number of arguments.
  * @param argv The arguments.
+ * @param exit_status Set to the exit status of the process, if not 0.
  */
-void ExecuteUserInput(int argc, char **argv) {
+void ExecuteUserInput(int argc, char **argv, int& exit_status) {
     size_t cmd_argument_count = argc;
     char** cmd_argument_values = argv;
 
@@ -435,11 +832,14 @@ void ExecuteUserInput(int argc, char **argv) {
         arguments.emplace_back(cmd_argument_values[i]);
     }
 
+    const ClientOptions options = ExtractClientOptions(arguments);
+
     /**
      * Non-config commands.
      */
 
     if (ListRegistered_Command(arguments)) return;
+    if (Reindex_Command(arguments)) return;
     if (CreateBuildInitializer_InternalCommand(arguments)) return;
     if (CreateProjectCloner_InternalCommand(arguments)) return;
     if (Register_Command(arguments)) return;
@@ -453,8 +853,10 @@ void ExecuteUserInput(int argc, char **argv) {
      */
 
     if (ListDefinitions_Command(arguments)) return;
+    if (Stats_Command(arguments)) return;
+    if (MultiTarget_Command(arguments, options, exit_status)) return;
     // The MOST important handler for the USER:
-    if (ConfigBased_Command(arguments)) return;
+    if (ConfigBased_Command(arguments, options)) return;
 
     /**
      * Still not handled? Explain to the USER that it was **not possible** to take an action.
@@ -467,13 +869,34 @@ void ExecuteUserInput(int argc, char **argv) {
     if (configWithCommand.has_value()) {
 
         cout << endl << string(kSpaceOutGroup, ' ') << "From the selected WebDash config at '" << configWithCommand->first.GetPath() << "':" << endl;
-        vector<string> commands = WebDashList(configWithCommand->first.GetPath());
+
+        // The config was just loaded, so it is indexed.
+        const auto entry = WebDashConfigIndex::Get().Find(configWithCommand->first.GetPath());
+        vector<string> commands = entry.has_value() ? entry->task_names : configWithCommand->first.GetTaskList();
 
         for (auto cmd : commands) {
             cout << string(kSpaceOutCommands, ' ') << cmd << endl;
         }
     }
 
+    /**
+     * Configs elsewhere in the workspace that have a task of the requested name.
+     */
+
+    if (!arguments.empty()) {
+        const string& argument = arguments.back();
+        const string task_name = argument.substr(argument.find(':') == string::npos ? 0 : argument.find(':') + 1);
+        const vector<string> config_paths = WebDashConfigIndex::Get().FindTask(task_name);
+
+        if (!task_name.empty() && !config_paths.empty()) {
+            cout << endl << string(kSpaceOutGroup, ' ') << "Configs with a task named '" << task_name << "':" << endl;
+
+            for (const auto& config_path : config_paths) {
+                cout << string(kSpaceOutCommands, ' ') << config_path << ":" << task_name << endl;
+            }
+        }
+    }
+
     vector<string> commands = WebDashNativeCommands();
 
     cout << endl << string(kSpaceOutGroup, ' ') << "WebDash's list of native commands:" << endl;
@@ -493,8 +916,10 @@ void ExecuteUserInput(int argc, char **argv) {
  */
 int main(int argc, char **argv) {
 
+    int exit_status = 0;
+
     try {
-        ExecuteUserInput(argc, argv);
+        ExecuteUserInput(argc, argv, exit_status);
     } catch (WebDashException::General& e) {
         cout << "ERROR: WebDash client received an WebDashException::General." << endl;
         cout << "MESSAGE: " << e.what() << endl;
@@ -509,5 +934,5 @@ int main(int argc, char **argv) {
         throw;
     }
 
-    return 0;
+    return exit_status;
 }
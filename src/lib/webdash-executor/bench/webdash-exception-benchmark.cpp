@@ -0,0 +1,92 @@
+/**
+ * Micro-benchmark: cost of throwing and catching a WebDashException::General from some stack depth, for each
+ * BacktraceCapture mode, and with the backtrace symbolized in the constructor (as General used to do).
+ *
+ * Usage: webdash-exception-benchmark [iterations] [stack depth]
+ *        Defaults: 20000 iterations; stack depth 20.
+ */
+
+#include "webdash-exceptions.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/* extern */ const string _WEBDASH_PROJECT_NAME_ = "webdash-exception-benchmark";
+
+
+namespace {
+
+    // Keeps the compiler from folding the recursion.
+    volatile size_t sink = 0;
+
+
+    [[gnu::noinline]] void ThrowAtDepth(int depth) {
+        if (depth <= 0) {
+            throw WebDashException::ConfigJsonParseError("Unable to parse as JSON. Format error?");
+        }
+
+        ThrowAtDepth(depth - 1);
+        sink = sink + 1;
+    }
+
+
+    /**
+     * @param symbolize If set, the caught exception's backtrace is symbolized, i.e., the cost of the former eager
+     *        symbolization in General's constructor is included.
+     * @returns The mean cost in microseconds of a throw and catch.
+     */
+    double MeasureThrowCatch(int iterations, int depth, bool symbolize) {
+        const auto start = chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; ++i) {
+            try {
+                ThrowAtDepth(depth);
+            } catch (const WebDashException::General& e) {
+                if (symbolize) {
+                    sink = sink + e.GetBacktraceSymbols().size();
+                }
+            }
+        }
+
+        const auto elapsed = chrono::steady_clock::now() - start;
+        return chrono::duration<double, micro>(elapsed).count() / iterations;
+    }
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+    const int depth = argc > 2 ? atoi(argv[2]) : 20;
+
+    struct Mode {
+        string name;
+        WebDashException::BacktraceCapture backtrace_capture;
+        bool symbolize;
+    };
+
+    const Mode modes[] = {
+        { "eager symbols (before)", WebDashException::BacktraceCapture::Addresses, true },
+        { "addresses", WebDashException::BacktraceCapture::Addresses, false },
+        { "none (default)", WebDashException::BacktraceCapture::None, false },
+    };
+
+    cout << setw(24) << "backtrace capture" << setw(20) << "throw/catch (us)" << endl;
+
+    for (const auto& mode : modes) {
+        WebDashException::SetBacktraceCapture(mode.backtrace_capture);
+
+        // Warm-up, e.g., for loading the unwinder.
+        MeasureThrowCatch(100, depth, mode.symbolize);
+
+        const double cost = MeasureThrowCatch(iterations, depth, mode.symbolize);
+        cout << setw(24) << mode.name << setw(20) << fixed << setprecision(2) << cost << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * Micro-benchmark: latency of starting (and reaping) a trivial child process through each WebDashProcessLauncher,
+ * depending on the size of the parent's heap.
+ *
+ * Usage: webdash-spawn-benchmark [iterations] [heap size in MiB]...
+ *        Defaults: 200 iterations; heap sizes 0, 256, 1024 MiB.
+ */
+
+#include "webdash-process.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+
+using namespace std;
+
+/* extern */ const string _WEBDASH_PROJECT_NAME_ = "webdash-spawn-benchmark";
+
+
+namespace {
+
+    /**
+     * @returns The mean latency in microseconds of launching `true` and waiting for it.
+     */
+    double MeasureLaunchLatency(WebDashProcessLauncher& launcher, int iterations) {
+        string program = "true";
+        vector<char*> argv = { program.data(), nullptr };
+
+        const auto start = chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; ++i) {
+            const pid_t pid = launcher.Launch(argv, nullopt, -1);
+
+            if (pid < 0) {
+                perror("Launch");
+                exit(1);
+            }
+
+            int status;
+            waitpid(pid, &status, 0);
+        }
+
+        const auto elapsed = chrono::steady_clock::now() - start;
+        return chrono::duration<double, micro>(elapsed).count() / iterations;
+    }
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? atoi(argv[1]) : 200;
+
+    vector<size_t> heap_sizes_mib;
+    for (int i = 2; i < argc; ++i) {
+        heap_sizes_mib.push_back(strtoul(argv[i], nullptr, 10));
+    }
+
+    if (heap_sizes_mib.empty()) {
+        heap_sizes_mib = { 0, 256, 1024 };
+    }
+
+    cout << setw(12) << "heap (MiB)" << setw(16) << "fork (us)" << setw(20) << "posix_spawn (us)" << endl;
+
+    for (size_t heap_size_mib : heap_sizes_mib) {
+        // Touch every page, so that it is actually mapped (and its page table entries exist).
+        const size_t heap_size = heap_size_mib << 20;
+        unique_ptr<char[]> heap(new char[heap_size + 1]);
+        memset(heap.get(), 1, heap_size);
+
+        const double fork_latency =
+            MeasureLaunchLatency(WebDashProcessLauncher::Get(WebDashType::LauncherType::Fork), iterations);
+        const double spawn_latency =
+            MeasureLaunchLatency(WebDashProcessLauncher::Get(WebDashType::LauncherType::PosixSpawn), iterations);
+
+        cout << setw(12) << heap_size_mib << setw(16) << fixed << setprecision(1) << fork_latency
+             << setw(20) << spawn_latency << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "webdash-types.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class WebDashOutputCapture;
+
+
+/**
+ * @class Content-addressed cache of action results in the app storage (kCacheDirectoryName).
+ *
+ *        An entry is keyed by a hash of everything that determines the result of an action: the resolved action
+ *        string, its working directory, the environment additions of the profile and the contents of the task's
+ *        declared inputs. It holds the return code, the recorded output and copies of the task's declared outputs
+ *        (artifacts). Only successful results are stored.
+ *
+ *        Entries are written to a temporary directory and renamed into place, so concurrent writers of the same key
+ *        do not corrupt each other.
+ */
+class WebDashActionCache {
+    public:
+
+        static constexpr char kCacheDirectoryName[] = "cache";
+
+        /**
+         * @param key The key of the action (see ComputeKey).
+         * @param base_directory The directory that the task's inputs and outputs are relative to.
+         */
+        WebDashActionCache(string key, std::filesystem::path base_directory);
+
+
+        /**
+         * @returns The key of an action.
+         * @param action The resolved action string.
+         * @param wdir The working directory of the action, if any.
+         * @param input_patterns The glob patterns of the task's inputs.
+         * @param base_directory The directory that the input patterns are relative to.
+         */
+        static string ComputeKey(const string& action,
+                                 const std::optional<string>& wdir,
+                                 const vector<string>& input_patterns,
+                                 const std::filesystem::path& base_directory);
+
+
+        /**
+         * @returns The directory in the app storage that holds the cache entries.
+         */
+        static std::filesystem::path GetCacheDirectory();
+
+
+        /**
+         * @brief On a hit, restores the artifacts and delivers the recorded output through the given capture, which
+         *        must record to GetRecordPath().
+         * @param capture The capture that delivers the output to the sinks of the run.
+         * @param ret The result that receives the return code and the output.
+         * @returns True on a hit; false if there is no (usable) entry for the key.
+         */
+        bool Restore(WebDashOutputCapture& capture, WebDashType::RunReturn& ret) const;
+
+
+        /**
+         * @returns The file that the output of the action is recorded to while it runs.
+         */
+        const std::filesystem::path& GetRecordPath() const { return _record_path; }
+
+
+        /**
+         * @brief Stores the result of an action that ran with output recorded to GetRecordPath(). Failed results are
+         *        discarded.
+         * @param return_code The return code of the action.
+         * @param output_patterns The glob patterns of the task's outputs, to be stored as artifacts.
+         */
+        void Store(int return_code, const vector<string>& output_patterns) const;
+
+    private:
+
+        static constexpr char kResultFilename[] = "result.json";
+        static constexpr char kOutputFilename[] = "output.log";
+        static constexpr char kArtifactsDirectoryName[] = "artifacts";
+
+        string _key;
+        std::filesystem::path _base_directory;
+        std::filesystem::path _entry_directory;
+        std::filesystem::path _record_path;
+};
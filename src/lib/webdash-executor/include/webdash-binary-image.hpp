@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * @class Builds a binary image (e.g., of WebDashConfigCache) field by field, in host byte order. Strings are prefixed
+ *        with their length.
+ */
+class WebDashImageWriter {
+    public:
+        void Bytes(const void* data, size_t size) { _image.append(static_cast<const char*>(data), size); }
+
+        void U8(uint8_t value) { Bytes(&value, sizeof(value)); }
+        void U32(uint32_t value) { Bytes(&value, sizeof(value)); }
+        void I64(int64_t value) { Bytes(&value, sizeof(value)); }
+
+        void String(const string& value) {
+            U32(static_cast<uint32_t>(value.size()));
+            Bytes(value.data(), value.size());
+        }
+
+        void OptionalString(const std::optional<string>& value) {
+            U8(value.has_value());
+            if (value.has_value()) String(value.value());
+        }
+
+        void Strings(const vector<string>& values) {
+            U32(static_cast<uint32_t>(values.size()));
+            for (const auto& value : values) String(value);
+        }
+
+        const string& Image() const { return _image; }
+
+
+        /**
+         * @brief Writes the image to a temporary file that is renamed to the path, so that readers never see a
+         *        partial image and concurrent writers do not corrupt each other. Creates the parent directory.
+         * @returns True on success; errno tells the reason otherwise.
+         */
+        bool WriteTo(const std::filesystem::path& path) const;
+
+    private:
+        string _image;
+};
+
+
+/**
+ * @class A read-only mapping of an image file.
+ */
+class WebDashMappedImage {
+    public:
+        explicit WebDashMappedImage(const std::filesystem::path& path);
+        ~WebDashMappedImage();
+
+        WebDashMappedImage(const WebDashMappedImage&) = delete;
+        WebDashMappedImage& operator=(const WebDashMappedImage&) = delete;
+
+        // False if the file does not exist or cannot be mapped. Empty files are not mapped either.
+        bool IsMapped() const { return _mapping != nullptr; }
+
+        const char* Begin() const { return static_cast<const char*>(_mapping); }
+        const char* End() const { return Begin() + _size; }
+
+    private:
+        void* _mapping = nullptr;
+        size_t _size = 0;
+};
+
+
+/**
+ * @class Reads the fields written by a WebDashImageWriter. Reading past the end fails the reader instead of throwing,
+ *        so a truncated image is simply not used.
+ */
+class WebDashImageReader {
+    public:
+        WebDashImageReader(const char* begin, const char* end) : _position(begin), _end(end) {}
+
+        explicit WebDashImageReader(const WebDashMappedImage& image) : WebDashImageReader(image.Begin(), image.End()) {}
+
+        bool Bytes(void* data, size_t size) {
+            if (!_ok || static_cast<size_t>(_end - _position) < size) return _ok = false;
+
+            memcpy(data, _position, size);
+            _position += size;
+            return true;
+        }
+
+        uint8_t U8() { uint8_t value = 0; Bytes(&value, sizeof(value)); return value; }
+        uint32_t U32() { uint32_t value = 0; Bytes(&value, sizeof(value)); return value; }
+        int64_t I64() { int64_t value = 0; Bytes(&value, sizeof(value)); return value; }
+
+        string String() {
+            const uint32_t size = U32();
+            if (!_ok || static_cast<size_t>(_end - _position) < size) { _ok = false; return {}; }
+
+            string value(_position, size);
+            _position += size;
+            return value;
+        }
+
+        std::optional<string> OptionalString() {
+            if (!U8()) return nullopt;
+            return String();
+        }
+
+        vector<string> Strings() {
+            vector<string> values(min<size_t>(U32(), _end - _position));
+            for (auto& value : values) value = String();
+            return values;
+        }
+
+        bool Ok() const { return _ok; }
+
+        bool AtEnd() const { return _position == _end; }
+
+    private:
+        const char* _position;
+        const char* _end;
+        bool _ok = true;
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "webdash-types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+
+using namespace std;
+
+class WebDashOutputCapture;
+
+
+/**
+ * @class Supervises launched children in a single event loop: the output pipes of all children are drained without
+ *        blocking and their termination is observed through pidfds, multiplexed with epoll. A completion event is
+ *        delivered once a child exited and its output reached EOF.
+ *
+ *        The loop runs on its own thread, which is started on first use. Output sinks (e.g.,
+ *        RunConfig::output_callback) and completion callbacks are invoked on that thread.
+ *
+ *        Children whose deadline passed, and all children once cancellation was requested (e.g., on Ctrl-C), are
+ *        terminated together with their process group: SIGTERM first, SIGKILL after kTerminationGracePeriod.
+ */
+class WebDashChildSupervisor {
+    public:
+
+        /**
+         * @struct How a child terminated.
+         */
+        struct ChildExit {
+            // As reported by wait4().
+            int status = 0;
+            struct rusage usage = {};
+
+            // Set if the child was terminated because its deadline passed or because of a cancellation.
+            bool timed_out = false;
+            bool cancelled = false;
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        // Time between SIGTERM and SIGKILL.
+        static constexpr std::chrono::seconds kTerminationGracePeriod{5};
+
+        // How often WaitPolling checks the child, the cancellation and the deadline.
+        static constexpr std::chrono::milliseconds kPollInterval{50};
+
+        using CompletionCallback = std::function<void(const ChildExit&)>;
+
+
+        /**
+         * @returns The process-wide supervisor.
+         */
+        static WebDashChildSupervisor& Get();
+
+
+        WebDashChildSupervisor(const WebDashChildSupervisor&) = delete;
+        WebDashChildSupervisor& operator=(const WebDashChildSupervisor&) = delete;
+
+        ~WebDashChildSupervisor();
+
+
+        /**
+         * @brief Requests the termination of all supervised children; children watched afterwards are terminated
+         *        right away. Async-signal-safe.
+         */
+        static void RequestCancellation();
+
+
+        /**
+         * @returns True once RequestCancellation() was called.
+         */
+        static bool IsCancellationRequested();
+
+
+        /**
+         * @brief Makes SIGINT (Ctrl-C) request the cancellation of all children. A second SIGINT terminates the
+         *        process as usual.
+         */
+        static void InstallInterruptHandler();
+
+
+        /**
+         * @brief Starts supervising a child. The child is reaped by the supervisor.
+         * @param pid The child, which must not have been waited for. Leads its own process group.
+         * @param capture The capture of the child's output, or nullptr. Must stay alive until completion; its read
+         *                end is made non-blocking.
+         * @param ret The result to which collected output is appended. Must stay alive until completion.
+         * @param on_completed Called on the supervisor thread once the child exited and its output was drained.
+         * @param deadline If set, the child's process group is terminated once this point in time passed.
+         * @returns False if the child cannot be supervised (e.g., pidfds are not supported by the kernel); the caller
+         *          remains responsible for it then.
+         */
+        bool Watch(pid_t pid,
+                   WebDashOutputCapture* capture,
+                   WebDashType::RunReturn* ret,
+                   CompletionCallback on_completed,
+                   std::optional<Clock::time_point> deadline = nullopt);
+
+
+        /**
+         * @brief Supervises a child (see Watch) and blocks until it completed.
+         * @returns How the child terminated, or nullopt if it cannot be supervised.
+         */
+        std::optional<ChildExit> WaitFor(pid_t pid,
+                                         WebDashOutputCapture* capture,
+                                         WebDashType::RunReturn* ret,
+                                         std::optional<Clock::time_point> deadline = nullopt);
+
+
+        /**
+         * @brief The fallback of WaitFor for children that cannot be supervised: waits on the calling thread, polling
+         *        the child every kPollInterval. Reads the output and terminates the process group on cancellation or
+         *        once the deadline passed, as the supervisor does.
+         * @returns How the child terminated; a status of -1 if it could not be reaped.
+         */
+        static ChildExit WaitPolling(pid_t pid,
+                                     WebDashOutputCapture* capture,
+                                     WebDashType::RunReturn* ret,
+                                     std::optional<Clock::time_point> deadline = nullopt);
+
+    private:
+
+        struct Child {
+            pid_t pid = -1;
+            int pidfd = -1;
+            WebDashOutputCapture* capture = nullptr;
+            WebDashType::RunReturn* ret = nullptr;
+            CompletionCallback on_completed;
+
+            bool exited = false;
+            bool output_finished = false;
+            ChildExit exit;
+
+            // Guarded by WebDashChildSupervisor::_mutex.
+            std::optional<Clock::time_point> deadline;
+            std::optional<Clock::time_point> kill_time;
+        };
+
+        WebDashChildSupervisor();
+
+
+        /**
+         * @brief The event loop. Runs until the supervisor is destroyed.
+         */
+        void Loop();
+
+
+        /**
+         * @brief Handles readiness of one of the child's file descriptors. Runs on the loop thread.
+         * @returns True if the child completed and was removed.
+         */
+        bool HandleEvent(Child& child, int fd);
+
+
+        /**
+         * @brief Sends SIGTERM to the child's process group and schedules SIGKILL. Requires _mutex.
+         */
+        void Terminate(Child& child);
+
+
+        /**
+         * @brief Terminates the children that are to be terminated by now (deadline passed, grace period over or
+         *        cancellation requested).
+         * @returns The time until the next deadline in milliseconds, or -1 if there is none.
+         */
+        int TerminateExpired();
+
+
+        int _epoll_fd = -1;
+
+        // Wakes up the loop to shut down, to cancel or to reconsider the deadlines.
+        int _wakeup_fd = -1;
+        std::atomic<bool> _stopping = false;
+
+        // Guards _children. Entries are only removed by the loop thread.
+        std::mutex _mutex;
+        unordered_map<int, shared_ptr<Child>> _children_by_pidfd;
+
+        std::thread _thread;
+};
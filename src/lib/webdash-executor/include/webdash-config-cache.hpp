@@ -0,0 +1,75 @@
+#pragma once
+
+#include "webdash-config-task.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * @class Compiled images of config files in the app storage (kCacheDirectoryName), so that loading an unchanged
+ *        config neither parses JSON nor probes and substitutes the task fields again.
+ *
+ *        An image holds the tasks of one config as they are after construction and substitution, in a flat binary
+ *        layout that is read straight from a read-only mapping. It is keyed by the canonical path of the config, the
+ *        file's identity (inode, size, modification and change time) and a hash of the profile substitutions;
+ *        any difference makes WebDashConfig::Load fall back to the JSON and write a new image.
+ *
+ *        Images are written to a temporary file and renamed into place, so concurrent writers do not corrupt them.
+ */
+class WebDashConfigCache {
+    public:
+
+        static constexpr char kCacheDirectoryName[] = "config-cache";
+
+        static constexpr char kMagic[8] = { 'W', 'D', 'C', 'F', 'G', 'I', 'M', 'G' };
+
+        // Bumped whenever the image layout or the set of task fields changes.
+        static constexpr uint32_t kFormatVersion = 2;
+
+        /**
+         * @struct What an image must match to be used.
+         */
+        struct Key {
+            uint64_t inode = 0;
+            uint64_t size = 0;
+            int64_t modification_time_ns = 0;
+            int64_t change_time_ns = 0;
+            uint64_t profile_hash = 0;
+        };
+
+
+        /**
+         * @returns The key of the config file in its current state; nullopt if it cannot be stat'ed.
+         * @param config_path The canonical path of the config.
+         * @param substitutions The substitutions applied to the config's tasks (see
+         *        WebDashConfig::GetProfileConfigSubtitutions).
+         */
+        static std::optional<Key> ComputeKey(const std::filesystem::path& config_path,
+                                             const vector<pair<string, string>>& substitutions);
+
+
+        /**
+         * @returns The tasks of the image of the config if it matches the key; nullopt otherwise. The actions of the
+         *          tasks still have to be compiled (see WebDashConfigTask::CompileActions).
+         */
+        static std::optional<vector<WebDashConfigTask>> Load(const std::filesystem::path& config_path, const Key& key);
+
+
+        /**
+         * @brief Writes the image of the config's tasks. Failures are logged only.
+         */
+        static void Store(const std::filesystem::path& config_path, const Key& key, const vector<WebDashConfigTask>& tasks);
+
+
+        /**
+         * @returns The path of the image of the config.
+         */
+        static std::filesystem::path GetImagePath(const std::filesystem::path& config_path);
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * @class The configs of the workspace with their task names, persisted in the app storage (kIndexFilename), so that
+ *        listing configs and tasks needs neither the server nor loading any config.
+ *
+ *        The index is updated incrementally: every successfully loaded WebDashConfig records itself, configs that
+ *        fail to load or disappear are dropped, and List() walks the WebDash root and loads only the configs that
+ *        are new or changed since they were indexed. Resolving a directory to its config (see
+ *        GetBestMatchingConfig) costs a single stat; configs that failed to load are not loaded again until they
+ *        change.
+ *
+ *        Several processes may update the index at the same time: Save merges the entries this process changed
+ *        into the persisted index under an flock (on kLockFilename), so entries recorded by others are kept.
+ */
+class WebDashConfigIndex {
+    public:
+
+        static constexpr char kIndexFilename[] = "config-index.bin";
+
+        static constexpr char kLockFilename[] = "config-index.lock";
+
+        static constexpr char kMagic[8] = { 'W', 'D', 'C', 'F', 'G', 'I', 'D', 'X' };
+
+        static constexpr uint32_t kFormatVersion = 2;
+
+        static constexpr char kConfigFilename[] = "webdash.config.json";
+
+        /**
+         * @struct An indexed config.
+         */
+        struct Entry {
+            // The canonical path.
+            string config_path;
+
+            // The file as it was when the task names were recorded.
+            uint64_t size = 0;
+            int64_t modification_time_ns = 0;
+
+            vector<string> task_names;
+        };
+
+
+        /**
+         * @returns The process-wide index, loaded from the app storage on first use.
+         */
+        static WebDashConfigIndex& Get();
+
+
+        /**
+         * @returns The path of the persisted index.
+         */
+        static std::filesystem::path GetIndexPath();
+
+
+        /**
+         * @returns The path of the directory's config (kConfigFilename) if it exists and did not fail to load in its
+         *          current state (see RecordLoadFailure); nullopt otherwise. An entry of a missing config is dropped.
+         */
+        std::optional<std::filesystem::path> FindConfigInDirectory(const std::filesystem::path& directory);
+
+
+        /**
+         * @returns The entry of the config; nullopt if it is not indexed, or not in its current state (size and
+         *          modification time).
+         */
+        std::optional<Entry> Find(const std::filesystem::path& config_path);
+
+
+        /**
+         * @returns The paths of the indexed configs that have a task with the given name, sorted. Configs changed
+         *          since they were indexed are left out.
+         */
+        vector<string> FindTask(const string& task_name);
+
+
+        /**
+         * @returns All configs below the WebDash root (and other indexed configs that still exist), sorted by path.
+         *          Loads the configs that are not indexed in their current state first, and drops the entries of
+         *          deleted configs.
+         */
+        vector<Entry> List();
+
+
+        /**
+         * @brief Adds or updates the entry of a loaded config.
+         */
+        void Record(const std::filesystem::path& config_path, const vector<string>& task_names);
+
+
+        /**
+         * @brief Drops the entry of a config that failed to load and remembers the failure (in this process) until
+         *        the file changes.
+         */
+        void RecordLoadFailure(const std::filesystem::path& config_path);
+
+
+        /**
+         * @brief Drops the entry of a config, e.g., as it was deleted.
+         */
+        void Erase(const std::filesystem::path& config_path);
+
+
+        /**
+         * @brief Replaces the index with the configs found below the WebDash root (skipping hidden directories and
+         *        the app storage), loading each of them.
+         * @returns The number of indexed configs.
+         */
+        size_t Rebuild();
+
+    private:
+
+        /**
+         * @returns The paths of the configs below the WebDash root (skipping hidden directories and the app storage),
+         *          canonical.
+         */
+        static vector<std::filesystem::path> FindConfigFiles();
+
+
+        /**
+         * @brief Reads the entries of the persisted index.
+         * @returns False if there is no index or it is unusable (entries is empty then).
+         */
+        static bool ReadIndex(unordered_map<string, Entry>& entries);
+
+
+        /**
+         * @brief Reads the persisted index, once. Requires _mutex.
+         */
+        void EnsureLoaded();
+
+
+        /**
+         * @brief Merges the entries changed by this process (_changed_paths) into the persisted index and takes over
+         *        the entries of others, unless a Rebuild is in progress (which saves once at its end). Requires _mutex.
+         */
+        void Save();
+
+
+        // Guards all members below.
+        std::mutex _mutex;
+
+        bool _loaded = false;
+
+        bool _rebuilding = false;
+
+        // Entries by canonical config path.
+        unordered_map<string, Entry> _entries;
+
+        // Config paths recorded or erased since the last Save; their state in _entries (or absence) wins when merging.
+        unordered_set<string> _changed_paths;
+
+        // The size and modification time of configs when they failed to load, by canonical config path.
+        unordered_map<string, pair<uint64_t, int64_t>> _failed_configs;
+};
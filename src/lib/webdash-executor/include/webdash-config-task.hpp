@@ -1,11 +1,15 @@
 #pragma once
 
 #include <chrono>
+#include <filesystem>
+#include <memory>
+#include <unordered_set>
 
 #include <nlohmann/json.hpp>
 
 #include "webdash-config-task.hpp"
 #include "webdash-types.hpp"
+#include "webdash-schedule.hpp"
 
 class WebDashConfig;
 
@@ -15,6 +19,10 @@ using namespace std::chrono;
 
 /**
  * @class Representative of a single webdash task from within a config file.
+ *
+ *        What the config defines is held in an immutable Definition shared by all copies of the task, so that
+ *        handing out tasks (e.g., WebDashConfig::GetTask, RunConfig::TaskRetriever) copies no strings. Each copy
+ *        has its own execution state (e.g., the last execution time).
  */
 class WebDashConfigTask {
     public:
@@ -25,6 +33,20 @@ class WebDashConfigTask {
         WebDashConfigTask(WebDashConfig*, const string, json);
 
 
+        /**
+         * @brief Compiles the actions into their typed representation: sub-task references or exec commands with a
+         *        prebuilt argv. An action is a sub-task reference if it is a single word that either contains a colon
+         *        (`:task`, `path:task`) or is the name of a task of the same config. Called once by WebDashConfig::Load.
+         *        A reference that does not resolve when run is executed as a command (see RunActions).
+         *
+         *        Dependencies of the form `:task` or naming a task of the same config are qualified with the config's
+         *        path likewise, so that they resolve to this config no matter which config the execution started from.
+         *
+         * @param config_task_names The names of all tasks of the task's config.
+         */
+        void CompileActions(const unordered_set<string>& config_task_names);
+
+
         /**
          * @brief If the task has a scheduled execution AND enough time has
          * passed for next execution, returns `true`. Otherwise, returns
@@ -36,46 +58,187 @@ class WebDashConfigTask {
          */
         bool ShouldExecuteTimewise(WebDashType::RunConfig config);
 
+        /**
+         * @returns The point in time from which on the task's `frequency` and `when` allow its next execution (in the
+         *          past if it never ran); nullopt if the task has neither a valid `frequency` nor a valid `when`, or
+         *          if its schedule never fires.
+         */
+        std::optional<std::chrono::high_resolution_clock::time_point> GetNextDueTime() const;
+
+        /**
+         * @brief Decides if the task is to be executed now (see ShouldExecuteTimewise) and, if so, records the
+         *        execution time and notifies the dashboard.
+         *
+         * @param config The task's execution parameters.
+         * @returns true if the task's actions should be run, false if the task is to be skipped.
+         */
+        bool BeginRun(WebDashType::RunConfig config);
+
+        /**
+         * @brief Logs that the task is skipped as it is not due, with its next due time. Only once until its next
+         *        execution.
+         */
+        void LogNotDue();
+
+        /**
+         * @brief Executes a single command (not a sub-task reference) in the task's working directory.
+         */
         WebDashType::RunReturn Run(WebDashType::RunConfig config, std::string action);
 
         WebDashType::RunReturn Run(WebDashType::RunConfig config = {});
 
-        string GetName() { return _name; }
+        /**
+         * @brief Runs the task's actions in order, without its dependencies and without checking the time
+         *        properties. Sub-task actions are run in place through config.TaskRetriever.
+         *
+         * @param config The task's execution parameters.
+         * @returns The combined result of all executed actions.
+         */
+        WebDashType::RunReturn RunActions(WebDashType::RunConfig config);
+
+        /**
+         * @returns True if the task declares `inputs`, they did not change since the last successful run and all
+         *          `outputs` exist, i.e., RunActions would skip the task. Executes nothing.
+         */
+        bool IsUpToDate(const WebDashType::RunConfig& config) const;
+
+        const string& GetName() const { return _definition->name; }
+
+        const string& GetTaskId() const { return _definition->taskid; }
+
+        const string& GetConfigPath() const { return _definition->config_path; }
+
+        const vector<string>& GetDependencies() const { return _definition->dependencies; }
+
+        const vector<WebDashType::CompiledAction>& GetCompiledActions() const { return _definition->compiled_actions; }
+
+        const std::optional<string>& GetWorkingDirectory() const { return _definition->wdir; }
 
-        bool IsValid() { return _is_valid; }
+        bool ContinuesOnError() const { return _definition->continue_on_error; }
 
-        bool CanRunAsAncestor() { return _allow_execution_as_ancestor; }
+        bool IsValid() const { return _definition->is_valid; }
+
+        bool CanRunAsAncestor() const { return _definition->allow_execution_as_ancestor; }
 
     private:
 
-        string _taskid;
-        std::optional<string> _frequency;
-        vector<string> _actions;
-        vector<string> _dependencies;
-        string _name;
-        std::optional<string> _wdir;
+        // Writes and restores the tasks' definitions (see WebDashConfigCache::Load).
+        friend class WebDashConfigCache;
 
-        // Per default, ::time_point is initialized to epoch.
-        std::chrono::high_resolution_clock::time_point _last_exec_time;
+        /**
+         * @struct The task as defined by its config, after substitutions.
+         */
+        struct Definition {
+            string taskid;
+            std::optional<string> frequency;
 
-        // Exactly that. Counts the number of times ::Run() was called.
-        int _times_called = 0;
+            // The parsed `frequency` and `when`; not set if missing or malformed.
+            std::optional<WebDashSchedule> frequency_schedule;
+            std::optional<WebDashSchedule> when_schedule;
 
-        // We want to print once if a task execution was skipped. We use this flag to
-        // skip such further logging.
-        bool _print_skip_has_happened = false;
+            // Shifts the due times: the hash of the task id within its `spread` (see WebDashSchedule::kDefaultSpread and
+            // WebDashSchedule::NextAfter). Calendar times are delayed by it; an interval keeps it as its phase.
+            std::chrono::milliseconds schedule_offset{ 0 };
+            vector<string> actions;
+            vector<WebDashType::CompiledAction> compiled_actions;
+            vector<string> dependencies;
+            string name;
+            std::optional<string> wdir;
+
+            // Glob patterns of the files the task reads and writes. If inputs are given, the task is skipped as long
+            // as their fingerprint matches the one of the last successful run and all outputs exist.
+            vector<string> inputs;
+            vector<string> outputs;
+
+            // "fingerprint": "content" hashes the input files; otherwise, only their size and modification time count.
+            bool fingerprint_contents = false;
 
-        // The task might be invalid due to some parameters wrongly set in the JSON.
-        // Not restricted to this example only.
-        bool _is_valid = true;
+            // "cache": true stores the results of the task's actions in the WebDashActionCache.
+            bool cache_results = false;
 
-        bool _notify_dashboard = false;
+            // "timeout": <seconds> terminates each of the task's actions that runs longer.
+            std::optional<std::chrono::milliseconds> timeout;
 
-        string _when_to_execute;
+            // The task might be invalid due to some parameters wrongly set in the JSON.
+            // Not restricted to this example only.
+            bool is_valid = true;
 
-        string _config_path;
+            bool notify_dashboard = false;
 
-        bool _continue_on_error = false;
+            string when_to_execute;
 
-        bool _allow_execution_as_ancestor = false;
+            string config_path;
+
+            bool continue_on_error = false;
+
+            bool allow_execution_as_ancestor = false;
+        };
+
+        /**
+         * @brief An empty task, filled by WebDashConfigCache.
+         */
+        WebDashConfigTask() = default;
+
+
+        /**
+         * @returns The definition for modification while the task is loaded; unshared first if copies of the task
+         *          exist.
+         */
+        Definition& MutableDefinition();
+
+
+        /**
+         * @brief Runs the dependencies (through config.TaskRetriever) and afterwards the actions of the task, adding
+         *        their results to @param ret. Completes the task's entry in config.memo, if any.
+         */
+        void RunDependenciesAndActions(WebDashType::RunConfig config, WebDashType::RunReturn& ret);
+
+        /**
+         * @returns The directory against which relative `inputs` and `outputs` are resolved: the working directory
+         *          if given, the directory of the config file otherwise.
+         */
+        std::filesystem::path GetFingerprintBaseDirectory() const;
+
+
+        /**
+         * @returns True if the task has a `frequency` or `when`, i.e., its last execution time matters.
+         */
+        bool HasTimeProperties() const { return _definition->frequency.has_value() || !_definition->when_to_execute.empty(); }
+
+
+        /**
+         * @brief Loads the last execution time recorded by previous processes, once.
+         */
+        void LoadLastExecTime() const;
+
+
+        /**
+         * @returns The exec action for the given command line, split on whitespace.
+         */
+        static WebDashType::CompiledAction CompileExec(const string& action);
+
+
+        /**
+         * @brief Launches a compiled exec action and waits for it to finish.
+         */
+        WebDashType::RunReturn RunExec(const WebDashType::RunConfig& config, const WebDashType::CompiledAction& action);
+
+        // Shared by all copies of the task; only modified while the task is loaded (see MutableDefinition).
+        std::shared_ptr<const Definition> _definition = std::make_shared<Definition>();
+
+        // Per default, ::time_point is initialized to epoch. For tasks with time properties, it is loaded lazily from
+        // the WebDashLastRuns on first use (see LoadLastExecTime), so that restarts do not run them again too early.
+        mutable std::chrono::high_resolution_clock::time_point _last_exec_time;
+        mutable bool _last_exec_time_loaded = false;
+
+        // Computed by GetNextDueTime once per execution.
+        mutable std::optional<std::chrono::high_resolution_clock::time_point> _next_due_time;
+        mutable bool _next_due_time_computed = false;
+
+        // Exactly that. Counts the number of times ::Run() was called.
+        int _times_called = 0;
+
+        // We want to print once if a task execution was skipped. We use this flag to
+        // skip such further logging.
+        bool _print_skip_has_happened = false;
 };
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 #include <nlohmann/json.hpp>
 #include <filesystem>
+#include <unordered_map>
 
 using namespace std;
 using json = nlohmann::json;
@@ -71,7 +72,8 @@ public:
     vector<string> GetTaskList();
 
     /**
-     * @returnsReturns a WebDashConfigTask object, given the task's name.
+     * @returnsReturns a WebDashConfigTask object, given the task's name. The "all" task if the name is empty.
+     *         Copying a task shares its definition.
      */
     std::optional<WebDashConfigTask> GetTask(const string command_name);
 
@@ -85,17 +87,18 @@ private:
 
 
     /**
-     *  @brief Loads the config and returns the array of tasks the config defines.
+     *  @brief Loads the config and returns the array of tasks the config defines. Does not throw on malformed
+     *         configs.
      *
      *  @param config_filepath The path to the WebDash config file.
-     *  @returnsAll tasks in the config.
-     *  @throw WebDashException::ConfigJsonParseError if pasing of the JSON failed.
+     *  @param failure_reason Receives the reason if loading failed.
+     *  @returnsAll tasks in the config or @retval nullopt if the config could not be opened or parsed.
      */
-    vector<WebDashConfigTask> Load(const std::filesystem::path config_filepath);
+    optional<vector<WebDashConfigTask>> Load(const std::filesystem::path config_filepath, string& failure_reason);
 
 
     /**
-     *  @brief Loads the config and catches a set of JSON parsing exceptions for which it returns @retval nullopt.
+     *  @brief Loads the config; logs a failure and records it in the WebDashConfigIndex.
      *
      *  @param config_filepath The path to the WebDash config file.
      *  @returnsAll tasks in the config or @retval nullopt if the config is an invalid JSON file.
@@ -103,9 +106,36 @@ private:
     optional<vector<WebDashConfigTask>> LoadAndCheckKnownFailures(const std::filesystem::path& config_filepath);
 
 
+    /**
+     *  @brief Compiles the actions of the config's tasks (see WebDashConfigTask::CompileActions).
+     */
+    static void CompileActions(vector<WebDashConfigTask>& tasks);
+
+
+    /**
+     *  @brief Adds the loaded config with its task names to the WebDashConfigIndex.
+     */
+    static void RecordInIndex(const std::filesystem::path& config_filepath, const vector<WebDashConfigTask>& tasks);
+
+
+    /**
+     *  @brief Replaces the tasks and rebuilds _task_indices.
+     */
+    void SetTasks(vector<WebDashConfigTask> tasks);
+
+
+    /**
+     *  @returns The task of the given name ("all" if empty); nullptr if there is none.
+     */
+    WebDashConfigTask* FindTask(const string& command_name);
+
+
     // The array of tasks in the config.
     vector<WebDashConfigTask> _tasks;
 
+    // The index in _tasks by task name. For duplicate names, the first task.
+    unordered_map<string, size_t> _task_indices;
+
     // The path to the location of the config file.
     std::filesystem::path _config_filepath;
 
@@ -146,3 +176,26 @@ inline std::optional<WebDashConfig> GetBestMatchingConfig(const std::filesystem:
  *          otherwise.
  */
 std::optional<ConfigAndCommand> GetConfigAndCommand(const vector<string>& arguments);
+
+
+/**
+ * @brief Runs several targets (each as accepted by a single-argument GetConfigAndCommand, e.g., `build`,
+ *        `dir:test`, `path/to/webdash.config.json:lint`) in one dependency graph. Each config is loaded once,
+ *        dependencies shared by the targets run once and the tasks of all targets share the
+ *        RunConfig::concurrency workers.
+ * @param targets The targets to run.
+ * @param runconfig The execution parameters. TaskRetriever is replaced.
+ * @returns One result per target, in the given order. Targets that could not be resolved to a valid task have a
+ *          non-zero return code.
+ */
+std::vector<WebDashType::RunReturn> RunTargets(const vector<string>& targets, WebDashType::RunConfig runconfig = {});
+
+
+/**
+ * @brief Resolves the targets, their dependencies and sub-task actions the same way RunTargets does, but executes
+ *        nothing (see WebDashDagExecutor::Plan).
+ * @param targets The targets to plan.
+ * @param runconfig The execution parameters the run would use (e.g., ignore_fingerprints). TaskRetriever is replaced.
+ * @returns The execution plan; `nullopt` if a target could not be resolved to a valid task.
+ */
+std::optional<WebDashType::ExecutionPlan> PlanTargets(const vector<string>& targets, WebDashType::RunConfig runconfig = {});
@@ -18,6 +18,7 @@
 #include <functional>
 #include <filesystem>
 #include <map>
+#include <mutex>
 
 using namespace std;
 
@@ -194,6 +195,9 @@ class WebDashCore {
         void _FinalizeInitialization(filesystem::path profile_filepath, vector<WebDashUtils::JsonEntry> key_values);
 
 
+        // Serializes Log() calls, which may come from several executor threads.
+        std::mutex _log_mutex;
+
         // Determines if the given LogType's file was previously cleared during this process' execution.
         std::map<WebDashType::LogType, bool> _logfile_was_cleared;
 
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "webdash-config-task.hpp"
+#include "webdash-task-graph.hpp"
+#include "webdash-types.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class WebDashWorkerPool;
+
+
+/**
+ * @class Runs one or more tasks together with all of their (transitive) dependencies.
+ *
+ *        First, the full dependency graph of the target task is linked (see WebDashTaskGraph) by resolving every
+ *        `dependencies` entry and sub-task action once through RunConfig::TaskRetriever (`:task`, `path:task`,
+ *        `$.rootDir()/...:task`). Each task is identified by its task id (`<config path>#<name>`), so a task reached
+ *        through several paths is a single node. A cycle is reported with its full path, and nothing is executed.
+ *
+ *        Afterwards, the nodes are executed on a WebDashWorkerPool with RunConfig::concurrency workers. A node is
+ *        ready as soon as all of its dependencies have finished; independent nodes run at the same time. The
+ *        actions of a single task (including sub-task actions, which are run in place) keep running in order.
+ *
+ *        Whenever a worker becomes free, it starts the ready node on the longest remaining path to the target, as
+ *        estimated from the durations of past runs (see WebDashTimingHistory::EstimateDuration). Long chains thereby
+ *        start early instead of waiting behind cheap tasks.
+ *
+ *        A node whose dependency failed is not executed, unless it sets `continue_on_error`.
+ *
+ *        If RunConfig::memo is set, tasks already executed during the same invocation (e.g., by a previous target or
+ *        as a sub-task action) are not executed again; their remembered result is used instead.
+ */
+class WebDashDagExecutor {
+    public:
+
+        /**
+         * @param config The execution parameters. TaskRetriever must be set.
+         */
+        explicit WebDashDagExecutor(WebDashType::RunConfig config);
+
+
+        /**
+         * @brief Executes the given task and its dependency graph.
+         * @param target The task to execute. Its run state (e.g., last execution time) is updated in place.
+         * @returns The combined result. Outputs are concatenated in dependency order (dependencies first, in the
+         *          order they are listed), the return codes are or-ed.
+         */
+        WebDashType::RunReturn Run(WebDashConfigTask& target);
+
+
+        /**
+         * @brief Executes several tasks and their dependency graphs as a single graph. Dependencies shared by the
+         *        targets run once, and the tasks of all targets share the workers.
+         * @param targets The tasks to execute. Their run state is updated in place.
+         * @returns One result per target, in the given order. A task needed by several targets contributes its
+         *          result to the first of them only.
+         */
+        vector<WebDashType::RunReturn> Run(const vector<WebDashConfigTask*>& targets);
+
+
+        /**
+         * @brief Resolves the dependency graph of the targets and the sub-task actions of its tasks like Run does,
+         *        but executes nothing and leaves the run state of the tasks untouched.
+         * @param targets The tasks to plan.
+         * @returns The tasks that would be considered for execution, with their estimated durations.
+         */
+        WebDashType::ExecutionPlan Plan(const vector<WebDashConfigTask*>& targets);
+
+    private:
+
+        // Assumed duration of tasks without history.
+        static constexpr std::chrono::milliseconds kUnknownDurationEstimate{1000};
+
+        // The node of a scheduled task has the index of the task's handle in _graph.
+        struct Node {
+            // False if the task is to be skipped due to its time properties (see
+            // WebDashConfigTask::ShouldExecuteTimewise and ::BeginRun) or because it already ran during this
+            // invocation.
+            bool should_run = true;
+
+            // Set if the task's inputs did not change since its last run (see WebDashConfigTask::IsUpToDate). Only
+            // determined when planning.
+            bool up_to_date = false;
+
+            // The estimated duration of the longest path from this node up to a target, including the node itself.
+            std::chrono::milliseconds critical_path{0};
+
+            // Guarded by WebDashDagExecutor::_mutex.
+            size_t pending_dependencies = 0;
+            bool dependency_failed = false;
+
+            WebDashType::RunReturn result;
+        };
+
+
+        /**
+         * @brief Links the targets into _graph and creates a node per scheduled task. Afterwards, TaskRetriever
+         *        answers references to linked tasks that only run in place from _graph.
+         * @param targets The tasks to start from.
+         */
+        void BuildGraph(const vector<WebDashConfigTask*>& targets);
+
+
+        /**
+         * @brief Creates the node of a newly linked scheduled task. Has no side effects on the task; Run begins the
+         *        runs (see WebDashConfigTask::BeginRun) only after ReportCycle found no cycle.
+         * @returns True if the task is to be run, i.e., its dependencies and sub-tasks are to be linked as well.
+         */
+        bool AddNode(WebDashTaskGraph::TaskHandle handle, WebDashConfigTask& task);
+
+
+        /**
+         * @returns nullopt if the graph is acyclic. Otherwise, the path of a cycle ("Dependency cycle: a -> b -> a"),
+         *          which is logged and printed to stderr as well.
+         */
+        std::optional<string> ReportCycle() const;
+
+
+        /**
+         * @brief Computes Node::critical_path of all nodes. Requires an acyclic graph.
+         */
+        void ComputeCriticalPaths();
+
+
+        /**
+         * @brief Queues nodes whose dependencies have finished and submits one job per node to the pool. Each job
+         *        runs the most critical node that is ready at the time it starts.
+         */
+        void Schedule(const vector<size_t>& node_indices);
+
+
+        /**
+         * @brief Executes the ready node with the longest critical path. Runs on a worker thread.
+         */
+        void ExecuteMostCritical();
+
+
+        /**
+         * @brief Executes the node and schedules the dependents that become ready. Runs on a worker thread.
+         */
+        void Execute(size_t node_index);
+
+
+        /**
+         * @brief Describes the linked task for Plan.
+         */
+        WebDashType::PlannedTask PlanTask(WebDashTaskGraph::TaskHandle handle) const;
+
+
+        /**
+         * @brief Combines the results of the node and its (transitive) dependencies, dependencies first. The return
+         *        code and the timeout and cancellation flags are those of all of them. Output and resource usage are
+         *        moved only from nodes not yet marked as collected, which are marked then.
+         */
+        WebDashType::RunReturn CollectResults(size_t node_index, vector<bool>& collected);
+
+
+        WebDashType::RunConfig _config;
+
+        // Set by Plan: tasks are only checked, not started (see AddNode).
+        bool _planning = false;
+
+        WebDashTaskGraph _graph;
+
+        vector<unique_ptr<Node>> _nodes;
+
+        WebDashWorkerPool* _pool = nullptr;
+
+        // Orders the ready nodes for _ready, which pops the greatest one: the longest critical path first; among equal
+        // ones, the first discovered.
+        struct LessCritical {
+            const WebDashDagExecutor* executor;
+            bool operator()(size_t lhs, size_t rhs) const;
+        };
+
+        // Guarded by _mutex.
+        std::priority_queue<size_t, vector<size_t>, LessCritical> _ready{ LessCritical{ this } };
+
+        // Guards the scheduling state of the nodes and _finished_count.
+        std::mutex _mutex;
+        std::condition_variable _all_finished;
+        size_t _finished_count = 0;
+};
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 #include <string>
@@ -24,44 +26,87 @@
 
 namespace WebDashException {
 
+    /**
+     * @brief Whether General captures the backtrace of where it was constructed. Capturing records the raw frame
+     *        addresses only; they are symbolized when the backtrace is printed.
+     */
+    enum class BacktraceCapture { None, Addresses };
+
+    // If set to anything but "0", backtraces are captured from the start.
+    static constexpr char kBacktraceEnvVarName[] = "WEBDASH_BACKTRACE";
+
+
+    /**
+     * @returns The process-wide switch for capturing backtraces. Off by default, so that exceptions that are
+     *          expected and caught do not pay for unwinding the stack.
+     */
+    inline std::atomic<BacktraceCapture>& GetBacktraceCaptureSwitch() {
+        static std::atomic<BacktraceCapture> backtrace_capture([]() {
+            const char* value = getenv(kBacktraceEnvVarName);
+            return value != nullptr && std::string(value) != "0" ? BacktraceCapture::Addresses : BacktraceCapture::None;
+        }());
+
+        return backtrace_capture;
+    }
+
+
+    inline void SetBacktraceCapture(const BacktraceCapture backtrace_capture) {
+        GetBacktraceCaptureSwitch().store(backtrace_capture, std::memory_order_relaxed);
+    }
+
+
     class General : public std::runtime_error {
         public:
             void ComputeBacktrace() {
 #ifdef _PLATFORM_LINUX
-                std::unique_ptr<void*[]> backtrace_buffer(new void*[BACKTRACE_BUFFER_SIZE]);
-
-
-                /**
-                 * @note These addresses point to the corresponding stack
-                 *       frames. @warning Do not access this buffer outside of
-                 *       this scope; unique_ptr is used for important reasons.
-                 */
+                void* backtrace_buffer[BACKTRACE_BUFFER_SIZE];
 
                 int backtrace_frames_count = backtrace(
-                    backtrace_buffer.get(),
+                    backtrace_buffer,
                     BACKTRACE_BUFFER_SIZE);
 
-                char **strings = backtrace_symbols(
-                    backtrace_buffer.get(),
-                    backtrace_frames_count);
+                backtrace_addresses.assign(backtrace_buffer, backtrace_buffer + backtrace_frames_count);
+#endif // _PLATFORM_LINUX
+            }
+
+            General(const std::string msg) : runtime_error(msg) {
+                if (GetBacktraceCaptureSwitch().load(std::memory_order_relaxed) == BacktraceCapture::Addresses) {
+                    ComputeBacktrace();
+                }
+            }
+
+            /**
+             * @returns The symbolized frames of the captured backtrace; empty if none was captured.
+             */
+            std::vector<std::string> GetBacktraceSymbols() const {
+                std::vector<std::string> backtrace_symbol_names;
+
+#ifdef _PLATFORM_LINUX
+                if (backtrace_addresses.empty()) {
+                    return backtrace_symbol_names;
+                }
+
+                std::unique_ptr<char*, decltype(&free)> strings(
+                    backtrace_symbols(backtrace_addresses.data(), static_cast<int>(backtrace_addresses.size())),
+                    &free);
 
-                if (strings == NULL) {
+                if (strings == nullptr) {
                     throw std::runtime_error(std::string("Error calling backtrace_symbols(): ") + strerror(errno));
                 }
 
-                for (int i = 0; i < backtrace_frames_count; ++i) {
-                    backtrace_symbol_names.push_back(strings[i]);
+                for (size_t i = 0; i < backtrace_addresses.size(); ++i) {
+                    backtrace_symbol_names.push_back(strings.get()[i]);
                 }
 #endif // _PLATFORM_LINUX
-            }
 
-            General(const std::string msg) : runtime_error(msg) {
-                ComputeBacktrace();
+                return backtrace_symbol_names;
             }
 
-            void PrintBacktrace(std::ostream& out) {
+            void PrintBacktrace(std::ostream& out) const {
+                const auto backtrace_symbol_names = GetBacktraceSymbols();
+
                 if (backtrace_symbol_names.size() == 0) {
-                    out << "Backtrace not available" << std::endl;
+                    out << "Backtrace not available (set " << kBacktraceEnvVarName << "=1 to capture it)" << std::endl;
                     return;
                 }
 
@@ -81,7 +126,8 @@ namespace WebDashException {
 
         private:
 
-            std::vector<std::string> backtrace_symbol_names;
+            // The return addresses of the frames, if captured (see BacktraceCapture).
+            std::vector<void*> backtrace_addresses;
     };
 
     class FileNotFound : public General {
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+
+namespace WebDashFingerprint {
+
+    /**
+     * @brief Computes the fingerprint of a task's declared inputs: the sorted list of matching files together with
+     *        their size and modification time and, optionally, a hash of their content.
+     *
+     * @param input_patterns The glob patterns of the inputs (see WebDashUtils::ExpandGlob).
+     * @param base_directory The directory against which relative patterns are resolved.
+     * @param hash_contents If set, the file contents are hashed as well (slower, but immune to touched files).
+     * @returns The fingerprint.
+     */
+    string ComputeInputFingerprint(const vector<string>& input_patterns,
+                                   const filesystem::path& base_directory,
+                                   bool hash_contents);
+
+
+    /**
+     * @brief Hashes the content of a task's declared inputs. Unlike ComputeInputFingerprint, only the paths relative to
+     *        the base directory and the contents count, so identical trees (e.g., after switching branches back and
+     *        forth) yield identical hashes.
+     *
+     * @param input_patterns The glob patterns of the inputs (see WebDashUtils::ExpandGlob).
+     * @param base_directory The directory against which relative patterns and paths are resolved.
+     * @param seed The hash to continue from.
+     * @returns The hash.
+     */
+    uint64_t HashInputContents(const vector<string>& input_patterns,
+                               const filesystem::path& base_directory,
+                               uint64_t seed);
+
+
+    /**
+     * @returns True if every output pattern matches at least one existing path.
+     */
+    bool OutputsExist(const vector<string>& output_patterns, const filesystem::path& base_directory);
+
+} // namespace WebDashFingerprint
+
+
+/**
+ * @class The input fingerprints of the last successful run of each task, persisted in the app storage
+ *        (kFingerprintsFilename). Loaded on first use; safe to use from several threads.
+ */
+class WebDashFingerprintStore {
+    public:
+
+        static constexpr char kFingerprintsFilename[] = "task-fingerprints.json";
+
+        /**
+         * @returns The process-wide store.
+         */
+        static WebDashFingerprintStore& Get();
+
+
+        /**
+         * @returns The fingerprint stored for the task, or nullopt if the task never ran successfully.
+         */
+        std::optional<string> Lookup(const string& taskid);
+
+
+        /**
+         * @brief Stores (and persists) the fingerprint of a successful run.
+         */
+        void Store(const string& taskid, const string& fingerprint);
+
+    private:
+
+        void LoadIfNeeded();
+
+        std::mutex _mutex;
+        bool _loaded = false;
+        unordered_map<string, string> _fingerprints;
+};
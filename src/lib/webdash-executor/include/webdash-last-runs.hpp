@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+using namespace std;
+
+
+/**
+ * @class The time of the last execution of each task with time properties (`frequency`, `when`), kept across process
+ *        restarts in the persistent app storage (kStateFilename). Safe to use from several threads and processes.
+ *
+ *        The file is a fixed-size header followed by an open-addressing hash table of Slots (keyed by the hash of the
+ *        task id), which is mapped into memory: a lookup is a few memory reads, an update a single store. When the
+ *        table runs full, a twice as large one is written to a new file that replaces the old one; the old file is
+ *        marked as moved, so that other processes map the new one on their next access.
+ */
+class WebDashLastRuns {
+    public:
+
+        static constexpr char kStateFilename[] = "task-last-runs.bin";
+
+        static constexpr char kMagic[8] = { 'W', 'D', 'L', 'R', 'U', 'N', 'S', '1' };
+
+        // Number of slots of a new table. Always a power of two.
+        static constexpr uint32_t kInitialSlotCount = 256;
+
+        /**
+         * @struct The file header.
+         */
+        struct Header {
+            char magic[8];
+            uint32_t slot_count;
+            uint32_t used_count;
+
+            // Set once the table was replaced by a larger one.
+            uint32_t moved;
+            uint32_t reserved;
+        };
+
+        /**
+         * @struct The last execution of a task. A slot with taskid_hash 0 is empty.
+         */
+        struct Slot {
+            // WebDashUtils::HashFnv1a of the task id (`<config path>#<name>`); 1 instead of 0.
+            uint64_t taskid_hash;
+
+            // Milliseconds since the Unix epoch.
+            int64_t last_run_unix_ms;
+        };
+
+        static_assert(std::is_trivially_copyable_v<Slot> && sizeof(Slot) == 16, "The slot layout is persisted.");
+
+
+        /**
+         * @returns The process-wide store.
+         */
+        static WebDashLastRuns& Get();
+
+
+        /**
+         * @returns The path of the state file.
+         */
+        static std::filesystem::path GetStatePath();
+
+
+        ~WebDashLastRuns();
+
+
+        /**
+         * @returns The time of the task's last recorded execution; nullopt if it never ran (or the file is unusable).
+         */
+        std::optional<std::chrono::system_clock::time_point> Lookup(const string& taskid);
+
+
+        /**
+         * @brief Records an execution of the task.
+         */
+        void Record(const string& taskid, std::chrono::system_clock::time_point time);
+
+    private:
+
+        /**
+         * @brief Maps the state file, creating it if needed; remaps it if it was replaced. Requires _mutex.
+         * @returns True if the file is mapped.
+         */
+        bool EnsureMapped();
+
+        void Unmap();
+
+
+        /**
+         * @brief Writes a table with twice the slots to a new file and puts it in place of the current one. Requires
+         *        _mutex and the flock of the current file.
+         * @returns True on success; the new file is mapped then.
+         */
+        bool Grow();
+
+
+        // Guards the mapping.
+        std::mutex _mutex;
+
+        int _fd = -1;
+        void* _mapping = nullptr;
+        size_t _mapping_size = 0;
+};
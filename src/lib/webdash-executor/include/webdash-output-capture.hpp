@@ -0,0 +1,196 @@
+#pragma once
+
+#include "webdash-types.hpp"
+
+#include <memory>
+#include <string>
+
+using namespace std;
+
+
+/**
+ * @class Fixed-size ring buffer that keeps the last `capacity` bytes written to it.
+ */
+class WebDashTailBuffer {
+    public:
+
+        explicit WebDashTailBuffer(size_t capacity);
+
+        /**
+         * @brief Appends data, overwriting the oldest bytes once the capacity is reached.
+         */
+        void Write(std::string_view data);
+
+        /**
+         * @returns The total number of bytes written so far (including overwritten ones).
+         */
+        size_t GetTotalSize() const { return _total_size; }
+
+        /**
+         * @returns The number of bytes that are retained at most.
+         */
+        size_t GetCapacity() const { return _ring.size(); }
+
+        /**
+         * @returns The retained bytes, oldest first.
+         */
+        string ToString() const;
+
+    private:
+
+        string _ring;
+        size_t _total_size = 0;
+};
+
+
+/**
+ * @class Captures the stdout/stderr of a single action through a pipe and delivers it to the sinks requested by the
+ *        RunConfig: RunReturn::output (redirect_output_to_str), RunConfig::output_callback and the task's log file in
+ *        RunConfig::output_log_directory.
+ *
+ *        The pipe is enlarged (F_SETPIPE_SZ) and drained in large chunks. Collected output is read directly into the
+ *        tail of RunReturn::output. If the log file is the only sink, the data is moved from the pipe into the file
+ *        with splice() and never copied to user space.
+ *
+ *        With RunConfig::output_tail_limit, collected output is kept in a WebDashTailBuffer instead. Once the output
+ *        exceeds the limit, the complete output is spilled to a file in the app storage.
+ */
+class WebDashOutputCapture {
+    public:
+
+        // Size of a single read from the pipe.
+        static constexpr size_t kReadChunkSize = 64 * 1024;
+
+        // Requested pipe capacity. The kernel caps it at /proc/sys/fs/pipe-max-size.
+        static constexpr int kPipeSize = 1024 * 1024;
+
+
+        /**
+         * @brief Creates the pipe if any of the config's output sinks is set, and opens the task's log file.
+         * @param config The execution parameters that select the sinks.
+         * @param taskid The id of the task whose action is captured.
+         * @param action_index Distinguishes the spill files of the task's actions.
+         * @param record_path If set, the complete output is also written to this file (e.g., for the action cache).
+         *                    The output is then always captured; without any other sink, it is forwarded to stdout.
+         */
+        WebDashOutputCapture(const WebDashType::RunConfig& config,
+                             const string& taskid,
+                             int action_index = 0,
+                             const std::optional<std::filesystem::path>& record_path = nullopt);
+
+        WebDashOutputCapture(const WebDashOutputCapture&) = delete;
+        WebDashOutputCapture& operator=(const WebDashOutputCapture&) = delete;
+
+        ~WebDashOutputCapture();
+
+
+        /**
+         * @returns True if the output is captured (i.e., the child's output is to be redirected to GetChildFd()).
+         */
+        bool IsActive() const { return _read_fd != -1; }
+
+
+        /**
+         * @returns The write end of the pipe, to become the child's stdout/stderr; -1 if the output is not captured.
+         */
+        int GetChildFd() const { return _write_fd; }
+
+
+        /**
+         * @brief Closes the parent's copy of the write end. Must be called once the child was launched, as EOF is
+         *        only seen after all copies of the write end are closed.
+         */
+        void CloseChildFd();
+
+
+        /**
+         * @returns The read end of the pipe; -1 if the output is not captured.
+         */
+        int GetReadFd() const { return _read_fd; }
+
+
+        /**
+         * @brief Moves the currently available output to the sinks. Blocks until data is available unless the read
+         *        end was made non-blocking.
+         * @param ret The result to which collected output is appended.
+         * @returns False once the child closed its end of the pipe (or reading failed); true otherwise.
+         */
+        bool ReadAvailable(WebDashType::RunReturn& ret);
+
+
+        /**
+         * @brief Moves all output to the sinks until the child closes its end of the pipe.
+         * @param ret The result to which collected output is appended.
+         */
+        void DrainToEnd(WebDashType::RunReturn& ret);
+
+
+        /**
+         * @brief Delivers previously recorded output (see record_path) to the sinks, as if an action had produced it.
+         *        Without any sink, the output is written to stdout.
+         * @param recorded The file holding the recorded output.
+         * @param ret The result to which collected output is appended.
+         */
+        void Replay(const std::filesystem::path& recorded, WebDashType::RunReturn& ret);
+
+
+        /**
+         * @brief Truncates the log file of a task, if the config requests log files. Called once before the first
+         *        action of a task runs, so that the log holds the output of the latest execution only.
+         */
+        static void ResetLog(const WebDashType::RunConfig& config, const string& taskid);
+
+
+        /**
+         * @returns The path of the task's log file within the given directory.
+         */
+        static std::filesystem::path GetLogPath(const std::filesystem::path& log_directory, const string& taskid);
+
+
+        /**
+         * @returns The directory in the app storage that holds spilled output.
+         */
+        static std::filesystem::path GetSpillDirectory();
+
+    private:
+
+        /**
+         * @brief Delivers a chunk that was read to user space to the callback and the log file.
+         */
+        void Deliver(std::string_view chunk);
+
+        /**
+         * @brief Adds a chunk to the tail buffer; spills to a file once the tail limit is exceeded.
+         */
+        void KeepTail(std::string_view chunk);
+
+        /**
+         * @brief Moves the tail (and the spill file, if any) into the result. Called once the pipe reached EOF.
+         */
+        void FinishTail(WebDashType::RunReturn& ret);
+
+        string _taskid;
+        int _action_index = 0;
+
+        // Set if RunConfig::output_tail_limit applies.
+        std::optional<WebDashTailBuffer> _tail;
+        std::optional<std::filesystem::path> _spill_path;
+        int _spill_fd = -1;
+
+        bool _collect_to_str = false;
+        WebDashType::OutputChunkCallback _callback;
+
+        int _read_fd = -1;
+        int _write_fd = -1;
+        int _log_fd = -1;
+
+        // Receives a copy of all output (record_path), or the output in place of the terminal (stdout), if set.
+        int _record_fd = -1;
+        int _forward_fd = -1;
+
+        // True while the log file is the only sink and the kernel supports splicing into it.
+        bool _splice_to_log = false;
+
+        // Buffer for reads that are not collected into RunReturn::output.
+        unique_ptr<char[]> _buffer;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "webdash-types.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+using namespace std;
+
+
+/**
+ * @class Starts the process of a single task action. Implementations differ in how the child is created; all of them
+ *        apply the same setup (working directory, output redirection) before executing the program.
+ */
+class WebDashProcessLauncher {
+    public:
+
+        virtual ~WebDashProcessLauncher() = default;
+
+
+        /**
+         * @brief Starts `argv[0]` (looked up in PATH) with the given arguments. The child becomes the leader of a new
+         *        process group, so that it can be terminated together with everything it started (see
+         *        WebDashChildSupervisor). As that group never owns the terminal, the child's stdin is /dev/null: an
+         *        action waiting for input sees EOF instead of being stopped.
+         * @param argv The NULL-terminated argument list.
+         * @param wdir The working directory of the child. The parent's one is used if not given.
+         * @param output_fd If not -1, the child's stdout and stderr are redirected to this file descriptor.
+         * @returns The pid of the child, or -1 with errno set if the child could not be started.
+         */
+        virtual pid_t Launch(const vector<char*>& argv,
+                             const std::optional<string>& wdir,
+                             int output_fd) = 0;
+
+
+        /**
+         * @returns The launcher implementing the given type. posix_spawn falls back to fork() if the C library does
+         *          not support changing the working directory through spawn file actions.
+         */
+        static WebDashProcessLauncher& Get(WebDashType::LauncherType type);
+};
+
+
+/**
+ * @class Launches through fork() + execvp(). The cost of fork() grows with the size of the parent's address space, as
+ *        its page tables are copied.
+ */
+class WebDashForkLauncher : public WebDashProcessLauncher {
+    public:
+        pid_t Launch(const vector<char*>& argv, const std::optional<string>& wdir, int output_fd) override;
+};
+
+
+/**
+ * @class Launches through posix_spawnp(). glibc implements it with clone(CLONE_VM | CLONE_VFORK), so the parent's
+ *        address space is shared instead of copied and the cost does not depend on the parent's memory usage.
+ */
+class WebDashPosixSpawnLauncher : public WebDashProcessLauncher {
+    public:
+        pid_t Launch(const vector<char*>& argv, const std::optional<string>& wdir, int output_fd) override;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "webdash-types.hpp"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+
+/**
+ * @class Remembers the result of every task executed during one invocation (e.g., one WebDashConfig::Run call), so
+ *        that a task reached through several dependency paths is executed only once.
+ *
+ *        Results are keyed by the canonical task id (`<config path>#<name>`) and hold the task's own result, i.e.,
+ *        the result of its actions without the results of its dependencies (which are remembered under their own
+ *        ids). Safe to use from several threads.
+ */
+class WebDashRunMemo {
+    public:
+
+        /**
+         * @brief Claims the execution of a task. If the task already finished, its remembered result is returned
+         *        (without the output and the resource usage, which were already reported by the first
+         *        execution).
+         *        If another thread is executing it, waits for that execution to finish and returns its result.
+         *        Otherwise, the calling thread becomes the owner and must call Complete() afterwards.
+         *
+         *        A claim of a task that the calling thread is itself executing (a sub-task cycle) is reported as a
+         *        failed result instead of waiting forever.
+         *
+         * @param taskid The canonical task id.
+         * @returns The remembered result, or nullopt if the caller now owns the execution.
+         */
+        std::optional<WebDashType::RunReturn> Claim(const string& taskid);
+
+
+        /**
+         * @brief Stores the result of a previously claimed task and wakes up the threads waiting for it.
+         * @param taskid The canonical task id.
+         * @param result The task's own result.
+         */
+        void Complete(const string& taskid, const WebDashType::RunReturn& result);
+
+
+        /**
+         * @returns True if the task was claimed (it is either running or finished).
+         */
+        bool Contains(const string& taskid);
+
+    private:
+
+        struct Entry {
+            bool finished = false;
+            std::thread::id owner;
+            WebDashType::RunReturn result;
+        };
+
+        std::mutex _mutex;
+        std::condition_variable _completed;
+        unordered_map<string, Entry> _entries;
+};
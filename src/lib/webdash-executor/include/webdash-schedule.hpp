@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+
+/**
+ * @class A parsed `frequency` or `when` of a task. Parsed once when the config is loaded; afterwards, computing the
+ *        next execution time only scans bit masks.
+ *
+ *        Supported expressions:
+ *          - intervals: "hourly", "daily", milliseconds ("60000") or durations ("15m", "1h30m", "2d", "500ms")
+ *          - cron expressions with five fields (minute, hour, day of month, month, day of week), e.g., "0 2 * * 1-5",
+ *            with lists, ranges, steps and month or weekday names; the macros "@hourly", "@daily", "@midnight",
+ *            "@weekly", "@monthly" and "@yearly"
+ *          - times of day, optionally preceded by the days: "02:00", "weekdays 02:00", "weekends 10:30",
+ *            "mon,wed,fri 18:00", "daily 02:00"
+ *          - "new-day": at midnight
+ *
+ *        Calendar times are in local time. A task is due at the first calendar time after its last execution, so
+ *        an execution that was missed (e.g., while no process was running) is caught up once.
+ */
+class WebDashSchedule {
+    public:
+
+        // The window in which the executions of tasks with calendar schedules (and no `spread`) are spread, so that,
+        // e.g., all "new-day" tasks do not start at the same second.
+        static constexpr std::chrono::minutes kDefaultSpread{ 10 };
+
+
+        /**
+         * @returns The schedule; nullopt if the expression is malformed.
+         */
+        static std::optional<WebDashSchedule> Parse(const string& expression);
+
+
+        /**
+         * @param last_execution The time of the task's last execution (the epoch if it never ran).
+         * @returns The time from which on the task is due again; nullopt if the schedule never fires (e.g.,
+         *          "0 0 30 2 *").
+         */
+        std::optional<std::chrono::system_clock::time_point> NextAfter(std::chrono::system_clock::time_point last_execution) const;
+
+
+        /**
+         * @brief As NextAfter, with the due times shifted by a fixed per-task offset (e.g., within a `spread`).
+         *        Calendar times are delayed by the offset. An interval keeps the offset as its phase instead: the
+         *        task is due at the first time `offset + k * interval` (since the epoch) after its last execution,
+         *        so the offset does not add up over the executions.
+         */
+        std::optional<std::chrono::system_clock::time_point> NextAfter(std::chrono::system_clock::time_point last_execution,
+                                                                       std::chrono::milliseconds offset) const;
+
+
+        /**
+         * @returns The milliseconds of a plain number ("60000") or a duration ("15m", "1h30m", "2d", "500ms");
+         *          nullopt if malformed.
+         */
+        static std::optional<std::chrono::milliseconds> ParseDuration(const string& expression);
+
+
+        bool IsInterval() const { return _interval.has_value(); }
+
+    private:
+
+        static std::optional<WebDashSchedule> ParseInterval(const string& expression);
+
+        static std::optional<WebDashSchedule> ParseCron(const string& expression);
+
+
+        /**
+         * @returns True if the local calendar day matches the day-of-month and day-of-week fields.
+         */
+        bool MatchesDay(int day_of_month, int weekday) const;
+
+
+        std::optional<std::chrono::milliseconds> _interval;
+
+        // Calendar schedules: bit i is set if the field value i matches.
+        uint64_t _minutes = 0;
+        uint32_t _hours = 0;
+        uint32_t _days_of_month = 0;
+        uint16_t _months = 0;
+        uint8_t _weekdays = 0;
+
+        // Set if the day field starts with '*' (e.g., `*` or `*/2`). As in cron, a day has to match both day fields
+        // if either of them starts with '*', and either of them otherwise.
+        bool _day_of_month_starts_with_star = true;
+        bool _weekday_starts_with_star = true;
+};
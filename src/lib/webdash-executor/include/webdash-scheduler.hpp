@@ -0,0 +1,170 @@
+#pragma once
+
+#include "webdash-config-task.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * @class Runs tasks with a schedule (`frequency` or `when`) whenever they are due, instead of polling every registered task.
+ *
+ *        The tasks are kept in a min-heap keyed by their next due time (see WebDashConfigTask::GetNextDueTime). The
+ *        scheduler thread sleeps until the earliest due time (or until a task is added) and then pops exactly the
+ *        tasks that are due, so a wake-up costs O(due tasks * log n), independently of the number of registered
+ *        tasks. Replaced and removed tasks are dropped lazily when they reach the top of the heap.
+ *
+ *        At most max_concurrent_tasks tasks run at the same time; further due tasks wait for a free thread. Together
+ *        with the per-task offsets within the `spread` (see WebDashConfigTask::GetNextDueTime), this keeps tasks
+ *        with the same schedule (e.g., all "new-day" tasks) from starting at once.
+ *
+ *        Library only: the client runs the requested targets once per invocation and does not use a scheduler, so
+ *        the cap applies to long-running hosts that create one (e.g., a server), not to `webdash <target>`.
+ */
+class WebDashScheduler {
+    public:
+
+        /**
+         * @brief Executes a due task, e.g., through a WebDashDagExecutor. Expected to call
+         *        WebDashConfigTask::BeginRun (which the executor does), as that moves the task's next due time. Called
+         *        from several threads at once if max_concurrent_tasks > 1.
+         */
+        using TaskRunner = std::function<void(WebDashConfigTask& task)>;
+
+        // Tasks whose next due time did not move forward after running are retried after this delay.
+        static constexpr std::chrono::seconds kMinimumRescheduleDelay{1};
+
+        static constexpr size_t kDefaultMaxConcurrentTasks = 2;
+
+
+        /**
+         * @param runner Runs the due tasks on the scheduler's threads.
+         * @param max_concurrent_tasks The number of scheduler threads, i.e., the limit on tasks running at once.
+         */
+        explicit WebDashScheduler(TaskRunner runner, size_t max_concurrent_tasks = kDefaultMaxConcurrentTasks);
+
+        WebDashScheduler(const WebDashScheduler&) = delete;
+        WebDashScheduler& operator=(const WebDashScheduler&) = delete;
+
+
+        /**
+         * @brief Stops the scheduler thread, if started.
+         */
+        ~WebDashScheduler();
+
+
+        /**
+         * @brief Adds the task, replacing a task with the same task id. If the replaced task is running at the moment,
+         *        the new one does not start before it finished.
+         * @returns False if the task has no valid schedule; it is not added then.
+         */
+        bool Add(WebDashConfigTask task);
+
+
+        /**
+         * @brief Removes all tasks of the given config (e.g., when it is unregistered or about to be reloaded). Tasks
+         *        running at the moment finish, but are not rescheduled.
+         * @returns The number of removed tasks.
+         */
+        size_t RemoveConfig(const string& config_path);
+
+
+        /**
+         * @brief Starts the threads that run the tasks when they are due.
+         */
+        void Start();
+
+
+        /**
+         * @brief Stops the threads after the tasks running at the moment (if any) finished.
+         */
+        void Stop();
+
+
+        /**
+         * @brief Runs all tasks due at the given time, one after another, and reschedules them. For callers running
+         *        their own loop (without Start()).
+         * @returns The next due time, or nullopt if no tasks are registered.
+         */
+        std::optional<std::chrono::steady_clock::time_point> RunDue(std::chrono::steady_clock::time_point now);
+
+
+        /**
+         * @returns The number of registered tasks.
+         */
+        size_t Size();
+
+    private:
+
+        struct Entry {
+            WebDashConfigTask task;
+            uint64_t generation;
+        };
+
+        struct DueTask {
+            std::chrono::steady_clock::time_point due_time;
+            string taskid;
+            uint64_t generation;
+
+            bool operator>(const DueTask& other) const { return due_time > other.due_time; }
+        };
+
+
+        /**
+         * @brief Takes the earliest task out of the heap if it is due at the given time and returns a copy of its
+         *        entry to run. Requires _mutex.
+         */
+        std::optional<pair<string, Entry>> TakeDue(std::chrono::steady_clock::time_point now);
+
+
+        /**
+         * @brief Runs a task taken by TakeDue and reschedules it, unless it was removed meanwhile. If it was replaced
+         *        meanwhile (i.e., the entry has another generation), the replacement is scheduled instead.
+         */
+        void Execute(const string& taskid, Entry entry);
+
+
+        /**
+         * @brief Pushes the entry's next due time to the heap. Requires _mutex.
+         */
+        void Schedule(const string& taskid, const Entry& entry, std::chrono::steady_clock::time_point not_before);
+
+
+        /**
+         * @brief Pops heap entries of replaced or removed tasks until the top is current. Requires _mutex.
+         */
+        void DropStale();
+
+
+        void Loop();
+
+
+        TaskRunner _runner;
+        const size_t _max_concurrent_tasks;
+
+        // Guards all members below.
+        std::mutex _mutex;
+        std::condition_variable _wakeup;
+
+        unordered_map<string, Entry> _entries;
+        std::priority_queue<DueTask, vector<DueTask>, std::greater<DueTask>> _due;
+        uint64_t _next_generation = 0;
+
+        // Task ids of the tasks being run at the moment. Their entries stay in _entries (without a heap entry).
+        unordered_set<string> _running;
+
+        vector<std::thread> _threads;
+        bool _stopping = false;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "webdash-config-task.hpp"
+#include "webdash-types.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * @class The linked graph of one or more target tasks: every task reachable through `dependencies` and sub-task
+ *        actions, across config files. Each task is interned once (by its task id) and identified by a dense
+ *        TaskHandle.
+ *
+ *        Linking resolves every reference (e.g., `path:task`) once through RunConfig::TaskRetriever. Afterwards, the
+ *        edges of a task are a contiguous range of handles (compressed sparse rows), so walking the graph neither
+ *        parses paths nor looks up strings.
+ *
+ *        The handles [0, ScheduledCount()) are the targets and their transitive dependencies, i.e., the tasks an
+ *        executor schedules. The remaining ones are only reached through sub-task actions, which run in place.
+ */
+class WebDashTaskGraph {
+    public:
+
+        using TaskHandle = uint32_t;
+
+        // Stands for exec actions and references that could not be resolved (see SubTasks).
+        static constexpr TaskHandle kNoTask = std::numeric_limits<TaskHandle>::max();
+
+        /**
+         * @brief Called once for every newly linked scheduled task. If it returns false, the task's dependencies and
+         *        sub-task actions are not followed (e.g., as the task is skipped).
+         */
+        using ExpandPredicate = std::function<bool(TaskHandle, WebDashConfigTask&)>;
+
+
+        /**
+         * @brief Links the targets and all tasks they reach. The targets are referenced, the other tasks are owned by
+         *        the graph. Dependencies that cannot be resolved are logged and left out. Must be called once.
+         * @param targets The tasks to start from.
+         * @param config Provides the TaskRetriever to resolve references with.
+         * @param expand Decides which scheduled tasks are followed.
+         */
+        void Link(const vector<WebDashConfigTask*>& targets, const WebDashType::RunConfig& config,
+                  const ExpandPredicate& expand);
+
+
+        /**
+         * @returns A cycle through dependencies or sub-task actions as the handles along it, with the first one
+         *          repeated at the end (`a`, `b`, `a`); nullopt if the graph is acyclic.
+         */
+        std::optional<vector<TaskHandle>> FindCycle() const;
+
+
+        /**
+         * @returns The task ids along the path, joined by " -> ".
+         */
+        string FormatPath(const vector<TaskHandle>& path) const;
+
+
+        /**
+         * @returns The handle of the task the reference (as written in a config) was linked to; kNoTask if it was not.
+         */
+        TaskHandle Find(const string& reference) const;
+
+
+        size_t Size() const { return _tasks.size(); }
+
+        size_t ScheduledCount() const { return _scheduled_count; }
+
+        WebDashConfigTask& Task(TaskHandle handle) const { return *_tasks[handle]; }
+
+        // The handles of the targets, in the given order (duplicates included).
+        const vector<TaskHandle>& Targets() const { return _targets; }
+
+        // The resolved dependencies of the task, in the order they are listed.
+        std::span<const TaskHandle> Dependencies(TaskHandle handle) const;
+
+        // The scheduled tasks that list the task as a dependency.
+        std::span<const TaskHandle> Dependents(TaskHandle handle) const;
+
+        // One entry per compiled action of the task: the sub-task it refers to, or kNoTask.
+        std::span<const TaskHandle> SubTasks(TaskHandle handle) const;
+
+    private:
+
+        /**
+         * @returns The handle of the task with the given reference, linking it if needed. kNoTask if it cannot be
+         *          resolved.
+         */
+        TaskHandle Resolve(const string& reference, const WebDashType::RunConfig& config);
+
+
+        /**
+         * @returns The handle of the task, interning it (as owned or referenced task) if needed.
+         */
+        TaskHandle Intern(std::optional<WebDashConfigTask> owned_task, WebDashConfigTask* task);
+
+
+        // Tasks by handle. Owned ones point into _owned_tasks, whose elements do not move.
+        vector<WebDashConfigTask*> _tasks;
+        deque<WebDashConfigTask> _owned_tasks;
+
+        unordered_map<string, TaskHandle> _handle_by_taskid;
+        unordered_map<string, TaskHandle> _handle_by_reference;
+
+        vector<TaskHandle> _targets;
+        size_t _scheduled_count = 0;
+
+        // Compressed sparse rows: the edges of handle h are [offsets[h], offsets[h + 1]) of the edge array.
+        vector<uint32_t> _dependency_offsets;
+        vector<TaskHandle> _dependency_edges;
+
+        vector<uint32_t> _dependent_offsets;
+        vector<TaskHandle> _dependent_edges;
+
+        vector<uint32_t> _subtask_offsets;
+        vector<TaskHandle> _subtask_edges;
+};
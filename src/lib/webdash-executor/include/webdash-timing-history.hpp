@@ -0,0 +1,168 @@
+#pragma once
+
+#include "webdash-types.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * @class Append-only history of task executions in the persistent app storage (kHistoryFilename).
+ *
+ *        The file starts with a small header (magic and record size), followed by fixed-size records. Each record is
+ *        appended with a single write() under an flock(), so several webdash processes can record at the same time.
+ *        Readers map the file into memory and scan the records without any parsing; tools other than webdash can
+ *        read it the same way.
+ *
+ *        It is also the source of the expected durations of tasks (see EstimateDuration) that the executor schedules
+ *        by and that plans show.
+ */
+class WebDashTimingHistory {
+    public:
+
+        static constexpr char kHistoryFilename[] = "task-timings.bin";
+
+        static constexpr char kMagic[8] = { 'W', 'D', 'T', 'I', 'M', 'E', 'S', '1' };
+
+        /**
+         * @struct The file header.
+         */
+        struct Header {
+            char magic[8];
+            uint32_t record_size;
+            uint32_t reserved;
+        };
+
+        /**
+         * @struct A single execution of a task. Times are in microseconds unless noted otherwise.
+         */
+        struct Record {
+            // WebDashUtils::HashFnv1a of the task id (`<config path>#<name>`).
+            uint64_t taskid_hash;
+
+            // Milliseconds since the Unix epoch.
+            int64_t start_unix_ms;
+            int64_t duration_us;
+
+            int32_t return_code;
+
+            // kTimedOut, kCancelled.
+            uint32_t flags;
+
+            int64_t user_cpu_us;
+            int64_t system_cpu_us;
+            int64_t max_rss_kb;
+            int64_t block_input_operations;
+            int64_t block_output_operations;
+            int64_t voluntary_context_switches;
+            int64_t involuntary_context_switches;
+
+            static constexpr uint32_t kTimedOut = 1 << 0;
+            static constexpr uint32_t kCancelled = 1 << 1;
+        };
+
+        static_assert(std::is_trivially_copyable_v<Record> && sizeof(Record) == 88, "The record layout is persisted.");
+
+
+        /**
+         * @struct Summary of the executions of a task (see ComputeStatistics).
+         */
+        struct Statistics {
+            size_t run_count = 0;
+            size_t failure_count = 0;
+
+            std::chrono::microseconds p50{0};
+            std::chrono::microseconds p95{0};
+            std::chrono::microseconds max{0};
+
+            // The median of the latest kTrendWindow runs relative to the median of the kTrendWindow runs before
+            // (e.g., 1.2 = 20% slower). Not set without enough runs.
+            std::optional<double> trend;
+
+            int64_t max_rss_kb = 0;
+        };
+
+        // Number of runs compared by Statistics::trend.
+        static constexpr size_t kTrendWindow = 10;
+
+        // Weight of the latest run in the moving average of EstimateDuration.
+        static constexpr double kLatestRunWeight = 0.3;
+
+
+        /**
+         * @returns The process-wide history.
+         */
+        static WebDashTimingHistory& Get();
+
+
+        /**
+         * @returns The path of the history file.
+         */
+        static std::filesystem::path GetHistoryPath();
+
+
+        /**
+         * @brief Appends an execution of a task.
+         * @param taskid The task.
+         * @param start_time When the task's actions started.
+         * @param duration The wall time of the task's actions.
+         * @param result The result of the task's actions (return code, resource usage).
+         */
+        void Append(const string& taskid,
+                    std::chrono::system_clock::time_point start_time,
+                    std::chrono::microseconds duration,
+                    const WebDashType::RunReturn& result);
+
+
+        /**
+         * @returns The recorded executions of the task, oldest first.
+         */
+        vector<Record> Read(const string& taskid) const;
+
+
+        /**
+         * @returns The expected duration of the task: an exponential moving average of the durations of its
+         *          successful runs, so that it follows lasting changes without being thrown off by a single outlier.
+         *          nullopt if it never ran successfully. The history is scanned once per process for all tasks;
+         *          runs appended by this process are added afterwards.
+         */
+        std::optional<std::chrono::milliseconds> EstimateDuration(const string& taskid);
+
+
+        /**
+         * @returns The statistics of the given executions, which are expected oldest first.
+         */
+        static Statistics ComputeStatistics(const vector<Record>& records);
+
+    private:
+
+        /**
+         * @brief Maps the history and calls @param visit for each record, oldest first.
+         */
+        static void ForEachRecord(const std::function<void(const Record&)>& visit);
+
+
+        /**
+         * @brief Adds a successful run to the moving average of its task. Requires _mutex.
+         */
+        void AddToEstimate(const Record& record);
+
+
+        // Guards appending from several threads of this process and the estimates.
+        std::mutex _mutex;
+
+        bool _estimates_loaded = false;
+
+        // The moving averages of EstimateDuration in microseconds, by Record::taskid_hash.
+        unordered_map<uint64_t, double> _estimated_duration_us_by_taskid_hash;
+};
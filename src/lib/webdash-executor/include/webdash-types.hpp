@@ -4,9 +4,17 @@
 #include <vector>
 #include <map>
 #include <functional>
+#include <memory>
+#include <filesystem>
+#include <string_view>
+#include <optional>
+#include <iterator>
+#include <chrono>
+#include <algorithm>
 using namespace std;
 
 class WebDashConfigTask;
+class WebDashRunMemo;
 
 namespace WebDashType {
 
@@ -51,6 +59,44 @@ namespace WebDashType {
         { WebDashType::LogType::DEBUG,  "debug"}
     };
 
+    /**
+     * @enum How the processes of task actions are created (see WebDashProcessLauncher).
+     */
+    enum class LauncherType {
+        Fork,
+        PosixSpawn
+    };
+
+    /**
+     * @struct A task action, compiled once when its config is loaded (see WebDashConfigTask::CompileActions).
+     */
+    struct CompiledAction {
+        enum class Kind {
+            Exec,
+            SubTask
+        };
+
+        /**
+         * @struct The arguments of an exec action and the NULL-terminated argv pointing into them. Shared between
+         *         copies of a task and never modified once built, so the pointers stay valid.
+         */
+        struct Argv {
+            vector<string> arguments;
+            vector<char*> pointers;
+        };
+
+        Kind kind = Kind::Exec;
+
+        // The action as given in the config (after substitutions).
+        string source;
+
+        // Kind::Exec only.
+        std::shared_ptr<const Argv> argv;
+
+        // Kind::SubTask only. The reference to resolve through RunConfig::TaskRetriever.
+        string reference;
+    };
+
     /**
      * @struct Information to manage a GIT project.
      */
@@ -61,6 +107,46 @@ namespace WebDashType {
         bool do_register;
     };
 
+    /**
+     * @struct Resources consumed by spawned actions (see wait4(2)). When combined, all values are summed up except
+     *         for max_rss_kb, which is the largest peak of any single action.
+     */
+    struct ResourceUsage {
+        std::chrono::nanoseconds wall_time{0};
+        std::chrono::nanoseconds user_cpu_time{0};
+        std::chrono::nanoseconds system_cpu_time{0};
+        long max_rss_kb = 0;
+        long block_input_operations = 0;
+        long block_output_operations = 0;
+        long voluntary_context_switches = 0;
+        long involuntary_context_switches = 0;
+
+        // The number of spawned processes accounted for.
+        size_t process_count = 0;
+
+        void Add(const ResourceUsage& other)
+        {
+            wall_time += other.wall_time;
+            user_cpu_time += other.user_cpu_time;
+            system_cpu_time += other.system_cpu_time;
+            max_rss_kb = std::max(max_rss_kb, other.max_rss_kb);
+            block_input_operations += other.block_input_operations;
+            block_output_operations += other.block_output_operations;
+            voluntary_context_switches += other.voluntary_context_switches;
+            involuntary_context_switches += other.involuntary_context_switches;
+            process_count += other.process_count;
+        }
+    };
+
+    /**
+     * @struct The resources consumed by a single action of a task.
+     */
+    struct ActionResourceUsage {
+        string taskid;
+        string action;
+        ResourceUsage usage;
+    };
+
     /**
      * @struct @todo
      */
@@ -68,21 +154,147 @@ namespace WebDashType {
         int return_code;
         string output;
 
+        // Files holding the complete output of actions whose output exceeded RunConfig::output_tail_limit. For
+        // those actions, `output` only holds the last output_tail_limit bytes.
+        vector<std::filesystem::path> output_spill_files;
+
+        // The resources consumed by all spawned actions, in total and per action (in execution order).
+        ResourceUsage resource_usage;
+        vector<ActionResourceUsage> action_resource_usage;
+
+        // Set if an action was terminated (or not started) because its timeout or RunConfig::deadline passed, or
+        // because the execution was cancelled (e.g., Ctrl-C). return_code is non-zero in that case.
+        bool timed_out = false;
+        bool cancelled = false;
+
         RunReturn()
         {
             return_code = 0;
             output = "";
         }
+
+        /**
+         * @brief Adds the result of a sub-task or action: or-s the return codes, appends the output and adds up the
+         *        resource usage. The output is moved if this result has none yet.
+         */
+        void Append(RunReturn&& other)
+        {
+            return_code |= other.return_code;
+
+            if (output.empty()) {
+                output = std::move(other.output);
+            } else {
+                output += other.output;
+            }
+
+            output_spill_files.insert(output_spill_files.end(),
+                                      std::make_move_iterator(other.output_spill_files.begin()),
+                                      std::make_move_iterator(other.output_spill_files.end()));
+
+            timed_out |= other.timed_out;
+            cancelled |= other.cancelled;
+
+            resource_usage.Add(other.resource_usage);
+            action_resource_usage.insert(action_resource_usage.end(),
+                                         std::make_move_iterator(other.action_resource_usage.begin()),
+                                         std::make_move_iterator(other.action_resource_usage.end()));
+        }
     };
 
+    /**
+     * @brief Receives the captured output of a task's actions while it is produced. May be called from several
+     *        executor threads at the same time; the chunks of a single task arrive in order.
+     */
+    using OutputChunkCallback = std::function<void(const string& taskid, std::string_view chunk)>;
+
     /**
      * @struct @todo
      */
     struct RunConfig {
         bool run_only_with_frequency = false;
         bool redirect_output_to_str = false;
+
+        // If not 0, redirect_output_to_str keeps only the last output_tail_limit bytes of each action's output in
+        // memory. The complete output of longer actions is spilled to the app storage (RunReturn::output_spill_files).
+        size_t output_tail_limit = 0;
+
+        // If set, the output of the actions is streamed to this callback (independently of redirect_output_to_str).
+        OutputChunkCallback output_callback;
+
+        // If set, the output of each task is written to <output_log_directory>/<task id>.log. If neither
+        // redirect_output_to_str nor output_callback is set, it is moved there with splice() (no copy to user space).
+        std::optional<std::filesystem::path> output_log_directory;
+
+        // Maximum number of tasks of the dependency graph that are executed at the same time.
+        int concurrency = 1;
+
+        // posix_spawn does not copy the parent's page tables, which matters for processes with a large heap.
+        LauncherType launcher = LauncherType::PosixSpawn;
+
+        // If set, tasks declaring `inputs` are executed even if their inputs did not change since the last run.
+        bool ignore_fingerprints = false;
+
+        // If set, tasks with `frequency` or `when` are executed even if they are not due. Their execution time is
+        // recorded as usual.
+        bool ignore_schedules = false;
+
+        // If not set, tasks with `"cache": true` neither use nor fill the action cache (see WebDashActionCache).
+        bool use_action_cache = true;
+
+        // If set, actions still running at this point in time are terminated, and later ones are not started.
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+
+        // Results of the tasks executed so far during this invocation. Tasks found in here are not run again.
+        std::shared_ptr<WebDashRunMemo> memo;
+
         std::function<std::optional<WebDashConfigTask>(string)> TaskRetriever;
     };
 
+    /**
+     * @struct A task as it would be executed (see WebDashDagExecutor::Plan).
+     */
+    struct PlannedTask {
+        string taskid;
+
+        // The working directory of the actions; the one of the client if not set.
+        std::optional<string> wdir;
+
+        vector<CompiledAction> actions;
+
+        // For each action, the task id its sub-task reference resolves to. Empty for exec actions and references
+        // that do not resolve.
+        vector<string> action_subtask_ids;
+
+        // The task ids of the resolved dependencies.
+        vector<string> dependency_ids;
+
+        // 0 for tasks without dependencies, otherwise one more than the highest level of the dependencies. Tasks of
+        // the same level may run at the same time.
+        size_t level = 0;
+
+        // Why the task would not be executed (e.g., "up to date"); empty if it would.
+        string skip_reason;
+
+        // The duration of past runs (see WebDashTimingHistory::EstimateDuration); not set for tasks without history.
+        std::optional<std::chrono::milliseconds> estimated_duration;
+
+        // The estimated duration of the longest path from this task up to a target, including the task itself.
+        std::chrono::milliseconds critical_path{0};
+    };
+
+    /**
+     * @struct The tasks a run of some targets would execute, without executing any of them.
+     */
+    struct ExecutionPlan {
+        // The tasks of the dependency graph, dependencies first (ordered by PlannedTask::level).
+        vector<PlannedTask> tasks;
+
+        // Tasks that are not part of the graph, but are run in place as sub-task actions (or as their dependencies).
+        vector<PlannedTask> subtasks;
+
+        // False if the dependency graph has a cycle; nothing would be executed then.
+        bool acyclic = true;
+    };
+
     using StoreWriteChannel = std::function<void(WebDashType::StorageWriteType, string)>;
 }
\ No newline at end of file
@@ -12,6 +12,8 @@
 #include <vector>
 #include <filesystem>
 #include <optional>
+#include <string_view>
+#include <cstdint>
 using namespace std;
 
 using SubstitutionPair = pair<string,string>;
@@ -145,4 +147,36 @@ namespace WebDashUtils {
      *          (e.g., /mnt/c/dir/).
      **/
     string GetDirectoryOfFilepath(const string& filepath);
+
+
+    /**
+     * @brief Expands a glob pattern (`*`, `?`, `[...]`) into the existing
+     *        paths that match it. A `**` component matches any number of
+     *        directories.
+     *
+     * @param pattern The pattern. Relative patterns are resolved against
+     *                `base_directory`.
+     * @param base_directory The directory for relative patterns.
+     * @returns The matching paths, sorted.
+     **/
+    vector<filesystem::path> ExpandGlob(const string& pattern,
+                                        const filesystem::path& base_directory);
+
+
+    /**
+     * @brief 64-bit FNV-1a hash. Not cryptographic; used to fingerprint
+     *        files and strings.
+     *
+     * @param data The bytes to hash.
+     * @param seed The hash to continue from, for hashing data in parts.
+     * @returns The hash value.
+     **/
+    uint64_t HashFnv1a(string_view data, uint64_t seed = 14695981039346656037ULL);
+
+
+    /**
+     * @param value A 64-bit value (e.g., a hash).
+     * @returns The value as a hexadecimal string of 16 characters.
+     **/
+    string ToHex(uint64_t value);
 }
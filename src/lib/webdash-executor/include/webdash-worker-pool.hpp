@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * @class Bounded pool of worker threads with per-worker job queues.
+ *
+ *        Jobs submitted from within a worker are pushed to the back of that worker's own queue and popped from the
+ *        back again (LIFO, cache friendly for chains of dependent jobs). Idle workers steal from the front of the
+ *        other workers' queues. Jobs submitted from outside of the pool are distributed in a round-robin fashion.
+ */
+class WebDashWorkerPool {
+    public:
+
+        using Job = std::function<void()>;
+
+
+        /**
+         * @brief Starts the given number of worker threads.
+         * @param worker_count The number of workers. Values smaller than 1 are treated as 1.
+         */
+        explicit WebDashWorkerPool(size_t worker_count);
+
+        WebDashWorkerPool(const WebDashWorkerPool&) = delete;
+        WebDashWorkerPool& operator=(const WebDashWorkerPool&) = delete;
+
+
+        /**
+         * @brief Finishes all queued jobs and joins the worker threads.
+         */
+        ~WebDashWorkerPool();
+
+
+        /**
+         * @brief Queues a job for execution on one of the workers.
+         * @param job The job to execute. Must not throw.
+         */
+        void Submit(Job job);
+
+
+        /**
+         * @returns The number of worker threads of the pool.
+         */
+        size_t GetWorkerCount() const { return _threads.size(); }
+
+    private:
+
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+
+        /**
+         * @brief Main loop of a single worker thread.
+         * @param worker_index The index of the worker's own queue.
+         */
+        void WorkerLoop(size_t worker_index);
+
+
+        /**
+         * @brief Takes the next job for the given worker: its own newest job first, otherwise the oldest job of any
+         *        other worker.
+         * @param worker_index The index of the worker's own queue.
+         * @returns The job to execute, or nullopt if all queues are empty.
+         */
+        std::optional<Job> TakeJob(size_t worker_index);
+
+
+        // One queue per worker thread.
+        vector<unique_ptr<WorkerQueue>> _queues;
+
+        vector<std::thread> _threads;
+
+        // Guards _queued_jobs and _stopping. Idle workers sleep on _wakeup. Taken before a queue mutex, never after.
+        std::mutex _wakeup_mutex;
+        std::condition_variable _wakeup;
+        size_t _queued_jobs = 0;
+        bool _stopping = false;
+
+        // Round-robin target for jobs submitted from outside of the pool.
+        size_t _next_external_queue = 0;
+};
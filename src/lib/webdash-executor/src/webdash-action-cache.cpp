@@ -0,0 +1,141 @@
+#include "webdash-action-cache.hpp"
+#include "webdash-core.hpp"
+#include "webdash-fingerprint.hpp"
+#include "webdash-output-capture.hpp"
+#include "webdash-utils.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using json = nlohmann::json;
+
+
+WebDashActionCache::WebDashActionCache(string key, std::filesystem::path base_directory)
+    : _key(std::move(key)), _base_directory(std::move(base_directory))
+{
+    const auto cache_directory = GetCacheDirectory();
+    std::filesystem::create_directories(cache_directory);
+
+    _entry_directory = cache_directory / _key;
+
+    // Unique per thread, as the same action might run concurrently in several invocations.
+    stringstream record_filename;
+    record_filename << _key << ".output." << getpid() << "." << std::this_thread::get_id();
+    _record_path = cache_directory / record_filename.str();
+}
+
+
+/* static */ string WebDashActionCache::ComputeKey(const string& action,
+                                                   const std::optional<string>& wdir,
+                                                   const vector<string>& input_patterns,
+                                                   const std::filesystem::path& base_directory) {
+    uint64_t hash = WebDashUtils::HashFnv1a(action + "\n");
+    hash = WebDashUtils::HashFnv1a(wdir.value_or("") + "\n", hash);
+
+    for (const auto& [name, value] : WebDashCore::Get().GetEnvironmentAdditions()) {
+        hash = WebDashUtils::HashFnv1a(name + "=" + value + "\n", hash);
+    }
+
+    hash = WebDashFingerprint::HashInputContents(input_patterns, base_directory, hash);
+
+    return WebDashUtils::ToHex(hash);
+}
+
+
+/* static */ std::filesystem::path WebDashActionCache::GetCacheDirectory() {
+    return WebDash().GetPersistenteAppStoragePath() / kCacheDirectoryName;
+}
+
+
+bool WebDashActionCache::Restore(WebDashOutputCapture& capture, WebDashType::RunReturn& ret) const {
+    std::error_code error;
+
+    if (!std::filesystem::is_directory(_entry_directory, error)) {
+        return false;
+    }
+
+    json result;
+
+    try {
+        ifstream stream(_entry_directory / kResultFilename);
+        stream >> result;
+
+        for (const auto& artifact : result["artifacts"]) {
+            const std::filesystem::path relative_path = artifact.get<string>();
+            const auto destination = _base_directory / relative_path;
+
+            std::filesystem::create_directories(destination.parent_path());
+            std::filesystem::copy(_entry_directory / kArtifactsDirectoryName / relative_path, destination,
+                                  std::filesystem::copy_options::recursive |
+                                  std::filesystem::copy_options::overwrite_existing);
+        }
+    } catch (const std::exception& e) {
+        WebDash().Log(WebDashType::LogType::WARN, "Ignoring the broken action cache entry " + _key + ": " + e.what());
+        return false;
+    }
+
+    capture.Replay(_entry_directory / kOutputFilename, ret);
+    ret.return_code = result.value("return_code", 0);
+
+    // Nothing is recorded on a hit.
+    std::filesystem::remove(_record_path, error);
+
+    return true;
+}
+
+
+void WebDashActionCache::Store(int return_code, const vector<string>& output_patterns) const {
+    std::error_code error;
+
+    if (return_code != 0) {
+        std::filesystem::remove(_record_path, error);
+        return;
+    }
+
+    const auto staging_directory = _record_path.string() + ".entry";
+    std::filesystem::remove_all(staging_directory, error);
+
+    try {
+        std::filesystem::create_directories(std::filesystem::path(staging_directory) / kArtifactsDirectoryName);
+        std::filesystem::rename(_record_path, std::filesystem::path(staging_directory) / kOutputFilename);
+
+        json artifacts = json::array();
+
+        for (const auto& pattern : output_patterns) {
+            for (const auto& path : WebDashUtils::ExpandGlob(pattern, _base_directory)) {
+                const auto relative_path = path.lexically_relative(_base_directory);
+
+                if (relative_path.empty() || *relative_path.begin() == "..") {
+                    WebDash().Log(WebDashType::LogType::WARN, "Not caching " + path.string() + ": outside of " + _base_directory.string());
+                    continue;
+                }
+
+                const auto destination = std::filesystem::path(staging_directory) / kArtifactsDirectoryName / relative_path;
+                std::filesystem::create_directories(destination.parent_path());
+                std::filesystem::copy(path, destination, std::filesystem::copy_options::recursive |
+                                                         std::filesystem::copy_options::overwrite_existing);
+
+                artifacts.push_back(relative_path.string());
+            }
+        }
+
+        json result;
+        result["return_code"] = return_code;
+        result["artifacts"] = artifacts;
+
+        ofstream(std::filesystem::path(staging_directory) / kResultFilename) << result.dump(4);
+
+        // Fails if another writer was faster; its entry is equivalent.
+        std::filesystem::rename(staging_directory, _entry_directory, error);
+    } catch (const std::exception& e) {
+        WebDash().Log(WebDashType::LogType::WARN, "Failed to store the action cache entry " + _key + ": " + e.what());
+    }
+
+    std::filesystem::remove_all(staging_directory, error);
+    std::filesystem::remove(_record_path, error);
+}
@@ -0,0 +1,74 @@
+#include "webdash-binary-image.hpp"
+
+#include <cerrno>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+bool WebDashImageWriter::WriteTo(const std::filesystem::path& path) const {
+    // Unique per thread, as the same image might be written concurrently.
+    stringstream temporary_path_stream;
+    temporary_path_stream << path.string() << ".tmp." << getpid() << "." << std::this_thread::get_id();
+    const string temporary_path = temporary_path_stream.str();
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    const int fd = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    bool written = fd != -1;
+    for (size_t offset = 0; written && offset < _image.size();) {
+        const ssize_t count = write(fd, _image.data() + offset, _image.size() - offset);
+
+        if (count < 0 && errno == EINTR) continue;
+        written = count > 0;
+        offset += written ? count : 0;
+    }
+
+    if (fd != -1) close(fd);
+
+    if (!written || rename(temporary_path.c_str(), path.c_str()) != 0) {
+        const int saved_errno = errno;
+        unlink(temporary_path.c_str());
+        errno = saved_errno;
+        return false;
+    }
+
+    return true;
+}
+
+
+WebDashMappedImage::WebDashMappedImage(const std::filesystem::path& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1) {
+        return;
+    }
+
+    struct stat file_stat;
+
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+        void* mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (mapping != MAP_FAILED) {
+            _mapping = mapping;
+            _size = file_stat.st_size;
+        }
+    }
+
+    close(fd);
+}
+
+
+WebDashMappedImage::~WebDashMappedImage() {
+    if (_mapping) {
+        munmap(_mapping, _size);
+    }
+}
@@ -0,0 +1,402 @@
+#include "webdash-child-supervisor.hpp"
+#include "webdash-output-capture.hpp"
+#include "webdash-core.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <future>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+namespace {
+
+    // Maximum number of events handled per epoll_wait().
+    constexpr int kMaxEvents = 64;
+
+    /**
+     * @returns A pidfd for the child, or -1 with errno set.
+     */
+    int OpenPidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+        return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+        errno = ENOSYS;
+        return -1;
+#endif
+    }
+
+    /**
+     * @brief Identifies the file descriptor (and its child) that an epoll event belongs to: the pidfd is stored in
+     *        the upper half, the file descriptor that became ready in the lower half.
+     */
+    uint64_t ToEventData(int pidfd, int fd) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(pidfd)) << 32) | static_cast<uint32_t>(fd);
+    }
+
+    // Written by the SIGINT handler; static, as the handler cannot reach the supervisor safely.
+    std::atomic<bool> s_cancellation_requested = false;
+    std::atomic<int> s_wakeup_fd = -1;
+
+    void WakeUp(int fd) {
+        const uint64_t one = 1;
+        /* unused */ (void) !write(fd, &one, sizeof(one));
+    }
+
+    /**
+     * @brief Asks the process group of the child to terminate.
+     */
+    void SignalTermination(pid_t pid) {
+        // Stopped children (e.g., reading from the terminal in the background) only act on SIGTERM once continued.
+        kill(-pid, SIGTERM);
+        kill(-pid, SIGCONT);
+    }
+
+    void OnInterrupt(int) {
+        WebDashChildSupervisor::RequestCancellation();
+
+        // The next Ctrl-C terminates right away.
+        signal(SIGINT, SIG_DFL);
+    }
+
+} // namespace
+
+
+/* static */ WebDashChildSupervisor& WebDashChildSupervisor::Get() {
+    static WebDashChildSupervisor supervisor;
+    return supervisor;
+}
+
+
+WebDashChildSupervisor::WebDashChildSupervisor() {
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    _wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if (_epoll_fd == -1 || _wakeup_fd == -1) {
+        WebDash().Log(WebDashType::LogType::ERR, string("Failed to set up the child supervisor: ") + strerror(errno));
+        return;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = ToEventData(-1, _wakeup_fd);
+    epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _wakeup_fd, &event);
+
+    s_wakeup_fd = _wakeup_fd;
+    _thread = std::thread([this]() { Loop(); });
+}
+
+
+WebDashChildSupervisor::~WebDashChildSupervisor() {
+    s_wakeup_fd = -1;
+
+    if (_thread.joinable()) {
+        _stopping = true;
+        WakeUp(_wakeup_fd);
+        _thread.join();
+    }
+
+    if (_epoll_fd != -1) close(_epoll_fd);
+    if (_wakeup_fd != -1) close(_wakeup_fd);
+}
+
+
+/* static */ void WebDashChildSupervisor::RequestCancellation() {
+    s_cancellation_requested = true;
+
+    const int wakeup_fd = s_wakeup_fd;
+    if (wakeup_fd != -1) {
+        WakeUp(wakeup_fd);
+    }
+}
+
+
+/* static */ bool WebDashChildSupervisor::IsCancellationRequested() {
+    return s_cancellation_requested;
+}
+
+
+/* static */ void WebDashChildSupervisor::InstallInterruptHandler() {
+    struct sigaction action = {};
+    action.sa_handler = OnInterrupt;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+
+    sigaction(SIGINT, &action, nullptr);
+}
+
+
+bool WebDashChildSupervisor::Watch(pid_t pid,
+                                   WebDashOutputCapture* capture,
+                                   WebDashType::RunReturn* ret,
+                                   CompletionCallback on_completed,
+                                   std::optional<Clock::time_point> deadline) {
+    if (!_thread.joinable()) {
+        return false;
+    }
+
+    const int pidfd = OpenPidfd(pid);
+
+    if (pidfd == -1) {
+        return false;
+    }
+
+    fcntl(pidfd, F_SETFD, FD_CLOEXEC);
+
+    auto child = make_shared<Child>();
+    child->pid = pid;
+    child->pidfd = pidfd;
+    child->capture = capture;
+    child->ret = ret;
+    child->on_completed = std::move(on_completed);
+    child->output_finished = capture == nullptr || !capture->IsActive();
+    child->deadline = deadline;
+
+    const int read_fd = child->output_finished ? -1 : capture->GetReadFd();
+
+    if (read_fd != -1) {
+        fcntl(read_fd, F_SETFL, fcntl(read_fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    {
+        lock_guard<mutex> lock(_mutex);
+        _children_by_pidfd[pidfd] = child;
+    }
+
+    // Level-triggered: a pipe that still holds data after a single read is reported again.
+    epoll_event event = {};
+    event.events = EPOLLIN;
+
+    if (read_fd != -1) {
+        event.data.u64 = ToEventData(pidfd, read_fd);
+        epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, read_fd, &event);
+    }
+
+    event.data.u64 = ToEventData(pidfd, pidfd);
+    epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, pidfd, &event);
+
+    // The loop has to consider the new deadline (or the pending cancellation).
+    if (deadline.has_value() || IsCancellationRequested()) {
+        WakeUp(_wakeup_fd);
+    }
+
+    return true;
+}
+
+
+std::optional<WebDashChildSupervisor::ChildExit> WebDashChildSupervisor::WaitFor(pid_t pid,
+                                                                                 WebDashOutputCapture* capture,
+                                                                                 WebDashType::RunReturn* ret,
+                                                                                 std::optional<Clock::time_point> deadline) {
+    std::promise<ChildExit> completed;
+    auto exit = completed.get_future();
+
+    auto on_completed = [&completed](const ChildExit& child_exit) { completed.set_value(child_exit); };
+
+    if (!Watch(pid, capture, ret, on_completed, deadline)) {
+        return nullopt;
+    }
+
+    return exit.get();
+}
+
+
+/* static */ WebDashChildSupervisor::ChildExit WebDashChildSupervisor::WaitPolling(pid_t pid,
+                                                                                 WebDashOutputCapture* capture,
+                                                                                 WebDashType::RunReturn* ret,
+                                                                                 std::optional<Clock::time_point> deadline) {
+    ChildExit exit;
+
+    // max() while no SIGKILL is pending.
+    Clock::time_point kill_time = Clock::time_point::max();
+
+    const int read_fd = capture != nullptr && capture->IsActive() ? capture->GetReadFd() : -1;
+    bool output_finished = read_fd == -1;
+    bool exited = false;
+
+    if (read_fd != -1) {
+        fcntl(read_fd, F_SETFL, fcntl(read_fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    while (!exited || !output_finished) {
+        if (!exited) {
+            const pid_t wpid = wait4(pid, &exit.status, WNOHANG, &exit.usage);
+
+            if (wpid == pid || (wpid == -1 && errno != EINTR)) {
+                if (wpid == -1) {
+                    WebDash().Log(WebDashType::LogType::ERR, "Failed to reap child " + to_string(pid) + ": " + strerror(errno));
+                    exit.status = -1;
+                }
+
+                exited = true;
+            }
+        }
+
+        // As long as the output is open, members of the process group may still be running.
+        const auto now = Clock::now();
+        const bool terminating = exit.cancelled || exit.timed_out;
+
+        if (!terminating && IsCancellationRequested()) {
+            WebDash().Log(WebDashType::LogType::INFO, "Cancelling child " + to_string(pid) + ".");
+            exit.cancelled = true;
+        } else if (!terminating && deadline.has_value() && deadline.value() <= now) {
+            WebDash().Log(WebDashType::LogType::WARN, "Child " + to_string(pid) + " timed out. Terminating its process group.");
+            exit.timed_out = true;
+        } else if (kill_time <= now) {
+            WebDash().Log(WebDashType::LogType::WARN, "Child " + to_string(pid) + " did not terminate. Killing its process group.");
+            kill(-pid, SIGKILL);
+            kill_time = Clock::time_point::max();
+        }
+
+        if (!terminating && (exit.cancelled || exit.timed_out)) {
+            SignalTermination(pid);
+            kill_time = now + kTerminationGracePeriod;
+        }
+
+        if (exited && output_finished) {
+            break;
+        }
+
+        // Sleeps until output arrives or for a poll interval.
+        pollfd poll_fd = { output_finished ? -1 : read_fd, POLLIN, 0 };
+
+        if (poll(&poll_fd, 1, static_cast<int>(kPollInterval.count())) > 0 && !capture->ReadAvailable(*ret)) {
+            output_finished = true;
+        }
+    }
+
+    return exit;
+}
+
+
+bool WebDashChildSupervisor::HandleEvent(Child& child, int fd) {
+    if (fd == child.pidfd && !child.exited) {
+        const pid_t wpid = wait4(child.pid, &child.exit.status, WNOHANG, &child.exit.usage);
+
+        if (wpid == child.pid || (wpid == -1 && errno != EINTR)) {
+            if (wpid == -1) {
+                WebDash().Log(WebDashType::LogType::ERR, "Failed to reap child " + to_string(child.pid) + ": " + strerror(errno));
+                child.exit.status = -1;
+            }
+
+            child.exited = true;
+            epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, child.pidfd, nullptr);
+        }
+    } else if (!child.output_finished) {
+        // Reads a single chunk; more data is reported again by the level-triggered epoll.
+        if (!child.capture->ReadAvailable(*child.ret)) {
+            child.output_finished = true;
+            epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+    }
+
+    return child.exited && child.output_finished;
+}
+
+
+void WebDashChildSupervisor::Terminate(Child& child) {
+    SignalTermination(child.pid);
+
+    child.deadline.reset();
+    child.kill_time = Clock::now() + kTerminationGracePeriod;
+}
+
+
+int WebDashChildSupervisor::TerminateExpired() {
+    const auto now = Clock::now();
+    const bool cancel = IsCancellationRequested();
+    std::optional<Clock::time_point> next;
+
+    lock_guard<mutex> lock(_mutex);
+
+    for (auto& [pidfd, child] : _children_by_pidfd) {
+        const bool terminating = child->exit.cancelled || child->exit.timed_out;
+
+        if (cancel && !terminating) {
+            WebDash().Log(WebDashType::LogType::INFO, "Cancelling child " + to_string(child->pid) + ".");
+            child->exit.cancelled = true;
+            Terminate(*child);
+        } else if (child->deadline.has_value() && child->deadline.value() <= now) {
+            WebDash().Log(WebDashType::LogType::WARN, "Child " + to_string(child->pid) + " timed out. Terminating its process group.");
+            child->exit.timed_out = true;
+            Terminate(*child);
+        } else if (child->kill_time.has_value() && child->kill_time.value() <= now) {
+            WebDash().Log(WebDashType::LogType::WARN, "Child " + to_string(child->pid) + " did not terminate. Killing its process group.");
+            kill(-child->pid, SIGKILL);
+            child->kill_time.reset();
+        }
+
+        for (const auto& time : { child->deadline, child->kill_time }) {
+            if (time.has_value() && (!next.has_value() || time.value() < next.value())) {
+                next = time;
+            }
+        }
+    }
+
+    if (!next.has_value()) {
+        return -1;
+    }
+
+    // Rounded up, so that the deadline has passed once epoll_wait() returns.
+    const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(next.value() - now);
+    return static_cast<int>(max<long long>(remaining.count(), 0));
+}
+
+
+void WebDashChildSupervisor::Loop() {
+    epoll_event events[kMaxEvents];
+
+    while (true) {
+        const int timeout_ms = TerminateExpired();
+        const int count = epoll_wait(_epoll_fd, events, kMaxEvents, timeout_ms);
+
+        if (count == -1) {
+            if (errno == EINTR) continue;
+
+            WebDash().Log(WebDashType::LogType::ERR, string("The child supervisor stopped: ") + strerror(errno));
+            return;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const int pidfd = static_cast<int32_t>(events[i].data.u64 >> 32);
+            const int fd = static_cast<int32_t>(events[i].data.u64 & 0xFFFFFFFF);
+
+            if (fd == _wakeup_fd) {
+                uint64_t value;
+                /* unused */ (void) !read(_wakeup_fd, &value, sizeof(value));
+
+                if (_stopping) return;
+                continue;
+            }
+
+            shared_ptr<Child> child;
+            {
+                lock_guard<mutex> lock(_mutex);
+                auto it = _children_by_pidfd.find(pidfd);
+                if (it == _children_by_pidfd.end()) continue;
+                child = it->second;
+            }
+
+            if (!HandleEvent(*child, fd)) {
+                continue;
+            }
+
+            {
+                lock_guard<mutex> lock(_mutex);
+                _children_by_pidfd.erase(pidfd);
+            }
+
+            close(child->pidfd);
+            child->on_completed(child->exit);
+        }
+    }
+}
@@ -0,0 +1,178 @@
+#include "webdash-config-cache.hpp"
+#include "webdash-binary-image.hpp"
+#include "webdash-core.hpp"
+#include "webdash-utils.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+
+#include <sys/stat.h>
+
+using namespace std;
+
+
+namespace {
+
+    /**
+     * @struct The start of an image; followed by the config path (images are named by its hash only) and the task
+     *         records.
+     */
+    struct ImageHeader {
+        char magic[8];
+        uint32_t format_version;
+        uint32_t task_count;
+        WebDashConfigCache::Key key;
+    };
+
+
+    int64_t ToNanoseconds(const struct timespec& time) {
+        return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    }
+
+} // namespace
+
+
+/* static */ std::filesystem::path WebDashConfigCache::GetImagePath(const std::filesystem::path& config_path) {
+    return WebDash().GetPersistenteAppStoragePath() / kCacheDirectoryName /
+           (WebDashUtils::ToHex(WebDashUtils::HashFnv1a(config_path.string())) + ".bin");
+}
+
+
+/* static */ std::optional<WebDashConfigCache::Key> WebDashConfigCache::ComputeKey(
+    const std::filesystem::path& config_path, const vector<pair<string, string>>& substitutions) {
+
+    struct stat file_stat;
+
+    if (stat(config_path.c_str(), &file_stat) != 0) {
+        return nullopt;
+    }
+
+    Key key;
+    key.inode = file_stat.st_ino;
+    key.size = file_stat.st_size;
+    key.modification_time_ns = ToNanoseconds(file_stat.st_mtim);
+    key.change_time_ns = ToNanoseconds(file_stat.st_ctim);
+
+    uint64_t profile_hash = WebDashUtils::HashFnv1a("");
+
+    for (const auto& [keyword, value] : substitutions) {
+        profile_hash = WebDashUtils::HashFnv1a(keyword, profile_hash);
+        profile_hash = WebDashUtils::HashFnv1a(string_view("\0", 1), profile_hash);
+        profile_hash = WebDashUtils::HashFnv1a(value, profile_hash);
+        profile_hash = WebDashUtils::HashFnv1a(string_view("\0", 1), profile_hash);
+    }
+
+    key.profile_hash = profile_hash;
+    return key;
+}
+
+
+/* static */ std::optional<vector<WebDashConfigTask>> WebDashConfigCache::Load(const std::filesystem::path& config_path,
+                                                                             const Key& key) {
+    const WebDashMappedImage image(GetImagePath(config_path));
+
+    if (!image.IsMapped()) {
+        return nullopt;
+    }
+
+    WebDashImageReader reader(image);
+
+    ImageHeader header = {};
+    reader.Bytes(&header, sizeof(header));
+
+    const bool matches = memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                         header.format_version == kFormatVersion &&
+                         reader.String() == config_path.string() &&
+                         header.key.inode == key.inode && header.key.size == key.size &&
+                         header.key.modification_time_ns == key.modification_time_ns &&
+                         header.key.change_time_ns == key.change_time_ns &&
+                         header.key.profile_hash == key.profile_hash;
+
+    std::optional<vector<WebDashConfigTask>> tasks;
+
+    if (matches) {
+        tasks.emplace();
+        tasks->reserve(min<size_t>(header.task_count, image.End() - image.Begin()));
+
+        for (uint32_t i = 0; i < header.task_count && reader.Ok(); ++i) {
+            WebDashConfigTask task;
+            WebDashConfigTask::Definition& definition = task.MutableDefinition();
+
+            definition.config_path = config_path.string();
+            definition.taskid = reader.String();
+            definition.name = reader.String();
+            definition.frequency = reader.OptionalString();
+            definition.when_to_execute = reader.String();
+            definition.schedule_offset = std::chrono::milliseconds(reader.I64());
+            definition.actions = reader.Strings();
+            definition.dependencies = reader.Strings();
+            definition.wdir = reader.OptionalString();
+            definition.inputs = reader.Strings();
+            definition.outputs = reader.Strings();
+
+            const int64_t timeout_ms = reader.I64();
+            if (timeout_ms >= 0) definition.timeout = std::chrono::milliseconds(timeout_ms);
+
+            const uint8_t flags = reader.U8();
+            definition.is_valid = flags & 1;
+            definition.fingerprint_contents = flags & 2;
+            definition.cache_results = flags & 4;
+            definition.notify_dashboard = flags & 8;
+            definition.continue_on_error = flags & 16;
+            definition.allow_execution_as_ancestor = flags & 32;
+
+            // Cheap and without logging, unlike the probing of the JSON fields.
+            if (definition.frequency.has_value()) definition.frequency_schedule = WebDashSchedule::Parse(definition.frequency.value());
+            if (!definition.when_to_execute.empty()) definition.when_schedule = WebDashSchedule::Parse(definition.when_to_execute);
+
+            tasks->push_back(std::move(task));
+        }
+
+        if (!reader.Ok() || !reader.AtEnd()) {
+            WebDash().Log(WebDashType::LogType::WARN, "Ignoring corrupt config image of " + config_path.string());
+            tasks.reset();
+        }
+    }
+
+    return tasks;
+}
+
+
+/* static */ void WebDashConfigCache::Store(const std::filesystem::path& config_path, const Key& key,
+                                            const vector<WebDashConfigTask>& tasks) {
+    ImageHeader header = {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.format_version = kFormatVersion;
+    header.task_count = static_cast<uint32_t>(tasks.size());
+    header.key = key;
+
+    WebDashImageWriter writer;
+    writer.Bytes(&header, sizeof(header));
+    writer.String(config_path.string());
+
+    for (const auto& task : tasks) {
+        const WebDashConfigTask::Definition& definition = *task._definition;
+
+        writer.String(definition.taskid);
+        writer.String(definition.name);
+        writer.OptionalString(definition.frequency);
+        writer.String(definition.when_to_execute);
+        writer.I64(definition.schedule_offset.count());
+        writer.Strings(definition.actions);
+        writer.Strings(definition.dependencies);
+        writer.OptionalString(definition.wdir);
+        writer.Strings(definition.inputs);
+        writer.Strings(definition.outputs);
+        writer.I64(definition.timeout.has_value() ? definition.timeout->count() : -1);
+        writer.U8((definition.is_valid ? 1 : 0) | (definition.fingerprint_contents ? 2 : 0) | (definition.cache_results ? 4 : 0) |
+                  (definition.notify_dashboard ? 8 : 0) | (definition.continue_on_error ? 16 : 0) |
+                  (definition.allow_execution_as_ancestor ? 32 : 0));
+    }
+
+    const auto image_path = GetImagePath(config_path);
+
+    if (!writer.WriteTo(image_path)) {
+        WebDash().Log(WebDashType::LogType::WARN, "Failed to write the config image " + image_path.string() + ": " + strerror(errno));
+    }
+}
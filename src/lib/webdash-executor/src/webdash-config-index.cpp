@@ -0,0 +1,410 @@
+#include "webdash-config-index.hpp"
+#include "webdash-binary-image.hpp"
+#include "webdash-config.hpp"
+#include "webdash-core.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+namespace {
+
+    /**
+     * @struct The start of the persisted index; followed by the entries.
+     */
+    struct IndexHeader {
+        char magic[8];
+        uint32_t format_version;
+        uint32_t entry_count;
+        uint32_t reserved[2];
+    };
+
+
+    /**
+     * @returns The size and modification time of the regular file; nullopt if there is none.
+     */
+    std::optional<pair<uint64_t, int64_t>> StatFile(const std::filesystem::path& path) {
+        struct stat file_stat;
+
+        if (stat(path.c_str(), &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+            return nullopt;
+        }
+
+        return pair<uint64_t, int64_t>{ file_stat.st_size,
+                                        static_cast<int64_t>(file_stat.st_mtim.tv_sec) * 1000000000 + file_stat.st_mtim.tv_nsec };
+    }
+
+
+    /**
+     * @returns True if the config file still has the size and modification time it had when it was indexed.
+     */
+    bool IsCurrent(const WebDashConfigIndex::Entry& entry) {
+        const auto file = StatFile(entry.config_path);
+        return file.has_value() && file->first == entry.size && file->second == entry.modification_time_ns;
+    }
+
+} // namespace
+
+
+/* static */ WebDashConfigIndex& WebDashConfigIndex::Get() {
+    static WebDashConfigIndex index;
+    return index;
+}
+
+
+/* static */ std::filesystem::path WebDashConfigIndex::GetIndexPath() {
+    return WebDash().GetPersistenteAppStoragePath() / kIndexFilename;
+}
+
+
+/* static */ bool WebDashConfigIndex::ReadIndex(unordered_map<string, Entry>& entries) {
+    entries.clear();
+
+    const WebDashMappedImage image(GetIndexPath());
+
+    if (!image.IsMapped()) {
+        return false;
+    }
+
+    WebDashImageReader reader(image);
+
+    IndexHeader header = {};
+    reader.Bytes(&header, sizeof(header));
+
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.format_version != kFormatVersion) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.entry_count && reader.Ok(); ++i) {
+        Entry entry;
+        entry.config_path = reader.String();
+        entry.size = static_cast<uint64_t>(reader.I64());
+        entry.modification_time_ns = reader.I64();
+        entry.task_names = reader.Strings();
+
+        entries[entry.config_path] = std::move(entry);
+    }
+
+    if (!reader.Ok() || !reader.AtEnd()) {
+        WebDash().Log(WebDashType::LogType::WARN, "Ignoring corrupt config index: " + GetIndexPath().string());
+        entries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+
+void WebDashConfigIndex::EnsureLoaded() {
+    if (_loaded) {
+        return;
+    }
+
+    _loaded = true;
+    ReadIndex(_entries);
+}
+
+
+void WebDashConfigIndex::Save() {
+    if (_rebuilding || _changed_paths.empty()) {
+        return;
+    }
+
+    // The index is replaced by rename, so the lock is taken on a file of its own.
+    const auto lock_path = WebDash().GetPersistenteAppStoragePath() / kLockFilename;
+    const int lock_fd = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+    if (lock_fd != -1) {
+        flock(lock_fd, LOCK_EX);
+    } else {
+        WebDash().Log(WebDashType::LogType::WARN, "Failed to lock the config index: " + string(strerror(errno)));
+    }
+
+    // Other processes might have changed other entries since this one read the index.
+    unordered_map<string, Entry> entries;
+    ReadIndex(entries);
+
+    for (const auto& config_path : _changed_paths) {
+        auto entry = _entries.find(config_path);
+
+        if (entry != _entries.end()) {
+            entries[config_path] = entry->second;
+        } else {
+            entries.erase(config_path);
+        }
+    }
+
+    _changed_paths.clear();
+    _entries = std::move(entries);
+
+    IndexHeader header = {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.format_version = kFormatVersion;
+    header.entry_count = static_cast<uint32_t>(_entries.size());
+
+    WebDashImageWriter writer;
+    writer.Bytes(&header, sizeof(header));
+
+    for (const auto& [config_path, entry] : _entries) {
+        writer.String(entry.config_path);
+        writer.I64(static_cast<int64_t>(entry.size));
+        writer.I64(entry.modification_time_ns);
+        writer.Strings(entry.task_names);
+    }
+
+    if (!writer.WriteTo(GetIndexPath())) {
+        WebDash().Log(WebDashType::LogType::WARN, "Failed to write the config index: " + string(strerror(errno)));
+    }
+
+    if (lock_fd != -1) {
+        flock(lock_fd, LOCK_UN);
+        close(lock_fd);
+    }
+}
+
+
+std::optional<std::filesystem::path> WebDashConfigIndex::FindConfigInDirectory(const std::filesystem::path& directory) {
+    const std::filesystem::path config_path = directory / kConfigFilename;
+    const auto file = StatFile(config_path);
+
+    if (file.has_value()) {
+        lock_guard<mutex> lock(_mutex);
+
+        auto failure = _failed_configs.find(config_path.string());
+        if (failure == _failed_configs.end()) {
+            return config_path;
+        }
+
+        if (failure->second == file.value()) {
+            return nullopt;
+        }
+
+        // Changed since it failed; worth another try.
+        _failed_configs.erase(failure);
+        return config_path;
+    }
+
+    {
+        lock_guard<mutex> lock(_mutex);
+        _failed_configs.erase(config_path.string());
+    }
+
+    Erase(config_path);
+    return nullopt;
+}
+
+
+std::optional<WebDashConfigIndex::Entry> WebDashConfigIndex::Find(const std::filesystem::path& config_path) {
+    lock_guard<mutex> lock(_mutex);
+    EnsureLoaded();
+
+    auto entry = _entries.find(config_path.string());
+    if (entry == _entries.end() || !IsCurrent(entry->second)) {
+        return nullopt;
+    }
+
+    return entry->second;
+}
+
+
+vector<string> WebDashConfigIndex::FindTask(const string& task_name) {
+    lock_guard<mutex> lock(_mutex);
+    EnsureLoaded();
+
+    vector<string> config_paths;
+
+    for (const auto& [config_path, entry] : _entries) {
+        if (find(entry.task_names.begin(), entry.task_names.end(), task_name) != entry.task_names.end() &&
+            IsCurrent(entry)) {
+            config_paths.push_back(config_path);
+        }
+    }
+
+    sort(config_paths.begin(), config_paths.end());
+    return config_paths;
+}
+
+
+vector<WebDashConfigIndex::Entry> WebDashConfigIndex::List() {
+    const auto config_paths = FindConfigFiles();
+
+    vector<std::filesystem::path> outdated_config_paths;
+
+    {
+        lock_guard<mutex> lock(_mutex);
+        EnsureLoaded();
+
+        // One stat per config drops those deleted since they were indexed...
+        for (auto it = _entries.begin(); it != _entries.end();) {
+            if (!StatFile(it->first).has_value()) {
+                _changed_paths.insert(it->first);
+                it = _entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        Save();
+
+        // ... and finds those added or changed since.
+        for (const auto& config_path : config_paths) {
+            auto entry = _entries.find(config_path.string());
+
+            if (entry == _entries.end() || !IsCurrent(entry->second)) {
+                auto failure = _failed_configs.find(config_path.string());
+
+                if (failure == _failed_configs.end() || failure->second != StatFile(config_path)) {
+                    outdated_config_paths.push_back(config_path);
+                }
+            }
+        }
+    }
+
+    // Each successfully loaded config records itself (see WebDashConfig::Load).
+    for (const auto& config_path : outdated_config_paths) {
+        try {
+            WebDashConfig config(config_path);
+        } catch (const std::exception& e) {
+            WebDash().Log(WebDashType::LogType::DEBUG, "Not indexed: " + config_path.string() + ". Reason: " + e.what());
+        }
+    }
+
+    lock_guard<mutex> lock(_mutex);
+
+    vector<Entry> entries;
+    entries.reserve(_entries.size());
+
+    for (const auto& [config_path, entry] : _entries) {
+        entries.push_back(entry);
+    }
+
+    sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.config_path < b.config_path; });
+    return entries;
+}
+
+
+void WebDashConfigIndex::Record(const std::filesystem::path& config_path, const vector<string>& task_names) {
+    const auto file = StatFile(config_path);
+
+    lock_guard<mutex> lock(_mutex);
+    EnsureLoaded();
+
+    if (!file.has_value()) {
+        return;
+    }
+
+    Entry& entry = _entries[config_path.string()];
+
+    if (entry.config_path == config_path.string() && entry.size == file->first &&
+        entry.modification_time_ns == file->second && entry.task_names == task_names) {
+        return;
+    }
+
+    entry.config_path = config_path.string();
+    entry.size = file->first;
+    entry.modification_time_ns = file->second;
+    entry.task_names = task_names;
+
+    _changed_paths.insert(entry.config_path);
+    Save();
+}
+
+
+void WebDashConfigIndex::RecordLoadFailure(const std::filesystem::path& config_path) {
+    const auto file = StatFile(config_path);
+
+    {
+        lock_guard<mutex> lock(_mutex);
+
+        if (file.has_value()) {
+            _failed_configs[config_path.string()] = file.value();
+        }
+    }
+
+    Erase(config_path);
+}
+
+
+void WebDashConfigIndex::Erase(const std::filesystem::path& config_path) {
+    lock_guard<mutex> lock(_mutex);
+    EnsureLoaded();
+
+    if (_entries.erase(config_path.string())) {
+        _changed_paths.insert(config_path.string());
+        Save();
+    }
+}
+
+
+/* static */ vector<std::filesystem::path> WebDashConfigIndex::FindConfigFiles() {
+    const auto& root = WebDash().GetWebDashRootDirectory();
+    const auto app_persistent_directory = root / "app-persistent";
+    const auto app_temporary_directory = root / "app-temporary";
+
+    vector<std::filesystem::path> config_paths;
+
+    std::error_code error;
+    auto it = std::filesystem::recursive_directory_iterator(root, std::filesystem::directory_options::skip_permission_denied, error);
+
+    for (; !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        const auto& path = it->path();
+
+        std::error_code status_error;
+
+        if (it->is_directory(status_error)) {
+            if (path.filename().string()[0] == '.' || path == app_persistent_directory || path == app_temporary_directory) {
+                it.disable_recursion_pending();
+            }
+        } else if (path.filename() == kConfigFilename) {
+            // The index is keyed by canonical path (see WebDashConfig).
+            auto canonical_path = std::filesystem::canonical(path, status_error);
+
+            if (!status_error) {
+                config_paths.push_back(std::move(canonical_path));
+            }
+        }
+    }
+
+    return config_paths;
+}
+
+
+size_t WebDashConfigIndex::Rebuild() {
+    const auto config_paths = FindConfigFiles();
+
+    {
+        lock_guard<mutex> lock(_mutex);
+        EnsureLoaded();
+
+        for (const auto& [config_path, entry] : _entries) {
+            _changed_paths.insert(config_path);
+        }
+
+        _entries.clear();
+        _rebuilding = true;
+    }
+
+    // Each successfully loaded config records itself (see WebDashConfig::Load).
+    for (const auto& config_path : config_paths) {
+        try {
+            WebDashConfig config(config_path);
+        } catch (const std::exception& e) {
+            WebDash().Log(WebDashType::LogType::DEBUG, "Not indexed: " + config_path.string() + ". Reason: " + e.what());
+        }
+    }
+
+    lock_guard<mutex> lock(_mutex);
+
+    _rebuilding = false;
+    Save();
+
+    return _entries.size();
+}
@@ -2,15 +2,28 @@
 #include "webdash-config-task.hpp"
 #include "webdash-core.hpp"
 #include "webdash-config.hpp"
+#include "webdash-run-memo.hpp"
+#include "webdash-process.hpp"
+#include "webdash-output-capture.hpp"
+#include "webdash-fingerprint.hpp"
+#include "webdash-action-cache.hpp"
+#include "webdash-child-supervisor.hpp"
+#include "webdash-last-runs.hpp"
 
 #include <cstdio>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <errno.h>
+#include <cstring>
 #include <sstream>
 #include <ctime>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
 using namespace std;
 
 
@@ -20,9 +33,11 @@ WebDashConfigTask::WebDashConfigTask(WebDashConfig* config,
 {
     WebDash().Log(WebDashType::LogType::DEBUG, "Loading Task: " + taskid);
 
-    this->_config_path = config->GetPath();
-    this->_taskid = taskid;
-    this->_is_valid = true;
+    Definition& definition = MutableDefinition();
+
+    definition.config_path = config->GetPath();
+    definition.taskid = taskid;
+    definition.is_valid = true;
 
     /**
      * Parse the webdash.config.json file.
@@ -30,11 +45,11 @@ WebDashConfigTask::WebDashConfigTask(WebDashConfig* config,
 
     try {
         const string name = task_config["name"].get<std::string>();
-        this->_name = name;
+        definition.name = name;
     }
     catch (...) {
         WebDash().Log(WebDashType::LogType::ERR, "T| " + taskid + ": field missing [name].");
-        _is_valid = false;
+        definition.is_valid = false;
         return;
     }
 
@@ -42,7 +57,7 @@ WebDashConfigTask::WebDashConfigTask(WebDashConfig* config,
         bool has_action = false;
         try {
             const string action = task_config["action"].get<std::string>();
-            this->_actions.push_back(action);
+            definition.actions.push_back(action);
             has_action = true;
         }
         catch (...){}
@@ -51,13 +66,13 @@ WebDashConfigTask::WebDashConfigTask(WebDashConfig* config,
             json actions = task_config["actions"];
 
             for (auto action : actions)
-                this->_actions.push_back(action.get<std::string>());
+                definition.actions.push_back(action.get<std::string>());
             has_action = true;
         }
         catch (...){}
 
         if (!has_action) {
-            _is_valid = false;
+            definition.is_valid = false;
             WebDash().Log(WebDashType::LogType::ERR, "T| " + taskid + ": field missing [actions].");
         }
     }
@@ -66,7 +81,7 @@ WebDashConfigTask::WebDashConfigTask(WebDashConfig* config,
         json dependencies = task_config["dependencies"];
 
         for (auto dependency : dependencies)
-            this->_dependencies.push_back(dependency.get<std::string>());
+            definition.dependencies.push_back(dependency.get<std::string>());
     }
     catch (...)
     {
@@ -76,7 +91,14 @@ WebDashConfigTask::WebDashConfigTask(WebDashConfig* config,
 
     try {
         const string frequency = task_config["frequency"].get<std::string>();
-        this->_frequency = frequency;
+        definition.frequency = frequency;
+
+        // Parsed once here; ShouldExecuteTimewise and the WebDashScheduler only compare time points.
+        definition.frequency_schedule = WebDashSchedule::Parse(frequency);
+
+        if (!definition.frequency_schedule.has_value()) {
+            WebDash().Log(WebDashType::LogType::INFO, "T| " + taskid + ": malformed frequency field. Never executed.");
+        }
     }
     catch (...)
     {
@@ -85,7 +107,12 @@ WebDashConfigTask::WebDashConfigTask(WebDashConfig* config,
 
     try {
         const string when = task_config["when"].get<std::string>();
-        this->_when_to_execute = when;
+        definition.when_to_execute = when;
+        definition.when_schedule = WebDashSchedule::Parse(when);
+
+        if (!definition.when_schedule.has_value()) {
+            WebDash().Log(WebDashType::LogType::INFO, "T| " + taskid + ": malformed when field. Ignored.");
+        }
     }
     catch (...) {
         WebDash().Log(WebDashType::LogType::WARN, "T| " + taskid + ": field missing [when] (remove this?).");
@@ -93,7 +120,7 @@ WebDashConfigTask::WebDashConfigTask(WebDashConfig* config,
 
     try {
         const string wdir = task_config["wdir"].get<std::string>();
-        this->_wdir = wdir;
+        definition.wdir = wdir;
     }
     catch (...)
     {
@@ -102,13 +129,13 @@ WebDashConfigTask::WebDashConfigTask(WebDashConfig* config,
 
     try {
         const bool continue_on_error = task_config["continue_on_error"].get<bool>();
-        this->_continue_on_error = continue_on_error;
+        definition.continue_on_error = continue_on_error;
     }
     catch (...){}
 
     try {
         const bool val = task_config["notify-dashboard"].get<bool>();
-        this->_notify_dashboard = val;
+        definition.notify_dashboard = val;
     }
     catch (...)
     {
@@ -117,275 +144,666 @@ WebDashConfigTask::WebDashConfigTask(WebDashConfig* config,
 
     try {
         const bool val = task_config["allow-execution-as-ancestor"].get<bool>();
-        this->_allow_execution_as_ancestor = val;
+        definition.allow_execution_as_ancestor = val;
     }
     catch (...) {
         WebDash().Log(WebDashType::LogType::WARN, "T| " + taskid + ": dashboard notification not specified.");
     }
 
+    try {
+        for (auto input : task_config.value("inputs", json::array()))
+            definition.inputs.push_back(input.get<std::string>());
+
+        for (auto output : task_config.value("outputs", json::array()))
+            definition.outputs.push_back(output.get<std::string>());
+    }
+    catch (...) {
+        WebDash().Log(WebDashType::LogType::ERR, "T| " + taskid + ": [inputs] and [outputs] must be lists of paths.");
+        definition.is_valid = false;
+    }
+
+    try {
+        // Executions of tasks with a calendar schedule are spread by default; a `spread` of "0" disables that.
+        const bool has_calendar_schedule =
+            (definition.frequency_schedule.has_value() && !definition.frequency_schedule->IsInterval()) ||
+            (definition.when_schedule.has_value() && !definition.when_schedule->IsInterval());
+
+        std::optional<std::chrono::milliseconds> spread;
+
+        if (task_config.contains("spread")) {
+            spread = WebDashSchedule::ParseDuration(task_config["spread"].get<std::string>());
+
+            if (!spread.has_value()) {
+                WebDash().Log(WebDashType::LogType::WARN, "T| " + taskid + ": malformed [spread]; not spread.");
+            }
+        } else if (has_calendar_schedule) {
+            spread = WebDashSchedule::kDefaultSpread;
+        }
+
+        // Deterministic per task, so that the offset does not move between checks or restarts.
+        if (spread.has_value() && spread->count() > 0) {
+            definition.schedule_offset = std::chrono::milliseconds(WebDashUtils::HashFnv1a(taskid) % spread->count());
+        }
+    }
+    catch (...) {
+        WebDash().Log(WebDashType::LogType::WARN, "T| " + taskid + ": [spread] must be a duration like \"30m\".");
+    }
+
+    try {
+        definition.cache_results = task_config.value("cache", false);
+
+        // Without inputs, the cache key would never change and stale results would be restored forever.
+        if (definition.cache_results && definition.inputs.empty()) {
+            WebDash().Log(WebDashType::LogType::WARN, "T| " + taskid + ": [cache] requires [inputs]; not cached.");
+            definition.cache_results = false;
+        }
+    }
+    catch (...) {
+        WebDash().Log(WebDashType::LogType::WARN, "T| " + taskid + ": [cache] must be true or false.");
+    }
+
+    try {
+        if (task_config.contains("timeout")) {
+            const double seconds = task_config["timeout"].get<double>();
+            definition.timeout = std::chrono::milliseconds(static_cast<long long>(seconds * 1000));
+        }
+    }
+    catch (...) {
+        WebDash().Log(WebDashType::LogType::ERR, "T| " + taskid + ": [timeout] must be a number of seconds.");
+        definition.is_valid = false;
+    }
+
+    try {
+        const string fingerprint = task_config.value("fingerprint", "mtime");
+
+        if (fingerprint == "content") {
+            definition.fingerprint_contents = true;
+        } else if (fingerprint != "mtime") {
+            WebDash().Log(WebDashType::LogType::WARN, "T| " + taskid + ": unknown [fingerprint] '" + fingerprint + "', using 'mtime'.");
+        }
+    }
+    catch (...) {
+        WebDash().Log(WebDashType::LogType::WARN, "T| " + taskid + ": [fingerprint] must be 'mtime' or 'content'.");
+    }
+
     //
     // Apply all keyword substitutions.
     //
 
     auto defs = config->GetProfileConfigSubtitutions();
-    _name = WebDashUtils::ApplySubstitutions(_name, defs);
+    definition.name = WebDashUtils::ApplySubstitutions(definition.name, defs);
 
-    for (auto& action : _actions) {
+    for (auto& action : definition.actions) {
         action = WebDashUtils::ApplySubstitutions(action, defs);
     }
 
-    for (auto& dependency : _dependencies) {
+    for (auto& dependency : definition.dependencies) {
         dependency = WebDashUtils::ApplySubstitutions(dependency, defs);
     }
 
-    if (_wdir.has_value()) {
-        _wdir = WebDashUtils::ApplySubstitutions(_wdir.value(), defs);
+    if (definition.wdir.has_value()) {
+        definition.wdir = WebDashUtils::ApplySubstitutions(definition.wdir.value(), defs);
+    }
+
+    for (auto& input : definition.inputs) {
+        input = WebDashUtils::ApplySubstitutions(input, defs);
+    }
+
+    for (auto& output : definition.outputs) {
+        output = WebDashUtils::ApplySubstitutions(output, defs);
     }
 }
 
-bool is_number(const std::string& s) {
-    char* end = 0;
-    const double val = strtod(s.c_str(), &end);
-    return end != s.c_str() && *end == '\0' && val != HUGE_VAL;
+namespace {
+
+    std::chrono::system_clock::time_point ToSystemTime(std::chrono::high_resolution_clock::time_point time) {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(time.time_since_epoch()));
+    }
+
+    std::chrono::high_resolution_clock::time_point FromSystemTime(std::chrono::system_clock::time_point time) {
+        return std::chrono::high_resolution_clock::time_point(
+            std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(time.time_since_epoch()));
+    }
+
+    std::chrono::nanoseconds ToDuration(const struct timeval& time) {
+        return std::chrono::seconds(time.tv_sec) + std::chrono::microseconds(time.tv_usec);
+    }
+
+    /**
+     * @returns The resource usage of a finished child, as reported by wait4().
+     */
+    WebDashType::ResourceUsage ToResourceUsage(const struct rusage& usage, std::chrono::nanoseconds wall_time) {
+        WebDashType::ResourceUsage ret;
+
+        ret.wall_time = wall_time;
+        ret.user_cpu_time = ToDuration(usage.ru_utime);
+        ret.system_cpu_time = ToDuration(usage.ru_stime);
+        ret.max_rss_kb = usage.ru_maxrss;
+        ret.block_input_operations = usage.ru_inblock;
+        ret.block_output_operations = usage.ru_oublock;
+        ret.voluntary_context_switches = usage.ru_nvcsw;
+        ret.involuntary_context_switches = usage.ru_nivcsw;
+        ret.process_count = 1;
+
+        return ret;
+    }
+
+    string FormatResourceUsage(const WebDashType::ResourceUsage& usage) {
+        auto ms = [](std::chrono::nanoseconds duration) {
+            return to_string(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count()) + "ms";
+        };
+
+        return "wall " + ms(usage.wall_time) + ", user " + ms(usage.user_cpu_time) + ", sys " + ms(usage.system_cpu_time) +
+               ", max rss " + to_string(usage.max_rss_kb) + "KiB, blocks in/out " + to_string(usage.block_input_operations) +
+               "/" + to_string(usage.block_output_operations) + ", context switches " +
+               to_string(usage.voluntary_context_switches) + "+" + to_string(usage.involuntary_context_switches);
+    }
+
+} // namespace
+
+
+WebDashConfigTask::Definition& WebDashConfigTask::MutableDefinition() {
+    if (_definition.use_count() > 1) {
+        _definition = std::make_shared<Definition>(*_definition);
+    }
+
+    // Created non-const by make_shared, and no other task refers to it.
+    return const_cast<Definition&>(*_definition);
 }
 
-bool WebDashConfigTask::ShouldExecuteTimewise(WebDashType::RunConfig config) {
 
-    const auto diff = std::chrono::high_resolution_clock::now() - _last_exec_time;
-    const auto diff_h = duration_cast<hours>(diff).count();
-    const auto diff_ms = duration_cast<milliseconds>(diff).count();
+void WebDashConfigTask::LoadLastExecTime() const {
+    if (_last_exec_time_loaded || !HasTimeProperties()) {
+        return;
+    }
 
-    // We expect frequency because of <run_only_with_frequency> but didn't get any.
-    if (config.run_only_with_frequency && !_frequency.has_value())
-        return false;
+    _last_exec_time_loaded = true;
 
-    bool enough_time_passed = true;
-    if (_frequency.has_value()) {
-        string freqv = _frequency.value();
+    if (auto last_run = WebDashLastRuns::Get().Lookup(_definition->taskid)) {
+        _last_exec_time = FromSystemTime(last_run.value());
+    }
+}
 
-        if (freqv != "daily" && !is_number(freqv)) {
-            WebDash().Log(WebDashType::LogType::INFO, "Malformed frequency field. Skipped.");
-            enough_time_passed = false;
-        }
 
-        if (diff_h < 24 && freqv == "daily") {
-            enough_time_passed = false;
-        } else if (diff_ms && is_number(freqv) && (diff_ms < stod(freqv))) {
-            enough_time_passed = false;
+std::optional<std::chrono::high_resolution_clock::time_point> WebDashConfigTask::GetNextDueTime() const {
+    // A malformed frequency never allows an execution; a malformed `when` is ignored.
+    if (_definition->frequency.has_value() != _definition->frequency_schedule.has_value() ||
+        (!_definition->frequency_schedule && !_definition->when_schedule)) {
+        return nullopt;
+    }
+
+    if (_next_due_time_computed) {
+        return _next_due_time;
+    }
+
+    LoadLastExecTime();
+
+    _next_due_time = FromSystemTime(std::chrono::system_clock::time_point::min());
+
+    for (const auto* schedule : { &_definition->frequency_schedule, &_definition->when_schedule }) {
+        if (!schedule->has_value()) continue;
+
+        const auto next_time = schedule->value().NextAfter(ToSystemTime(_last_exec_time), _definition->schedule_offset);
+
+        if (!next_time.has_value()) {
+            _next_due_time = nullopt;
+            break;
         }
+
+        _next_due_time = max(_next_due_time.value(), FromSystemTime(next_time.value()));
     }
 
-    if (enough_time_passed == false) {
+    _next_due_time_computed = true;
+    return _next_due_time;
+}
+
+
+bool WebDashConfigTask::ShouldExecuteTimewise(WebDashType::RunConfig config) {
+
+    // We expect frequency because of <run_only_with_frequency> but didn't get any.
+    if (config.run_only_with_frequency && !_definition->frequency.has_value())
         return false;
+
+    if (config.ignore_schedules)
+        return true;
+
+    if (_definition->frequency.has_value() || _definition->when_schedule.has_value()) {
+        const auto next_due_time = GetNextDueTime();
+
+        // A malformed frequency never allows an execution.
+        if (!next_due_time.has_value() || std::chrono::high_resolution_clock::now() < next_due_time.value()) {
+            return false;
+        }
     }
 
-    if (_when_to_execute == "new-day") {
-        std::time_t _time_last  = std::chrono::system_clock::to_time_t(_last_exec_time);
-        std::time_t _time_today = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    return true;
+}
+
+
+/* static */ WebDashType::CompiledAction WebDashConfigTask::CompileExec(const string& action) {
+    WebDashType::CompiledAction compiled;
+    compiled.kind = WebDashType::CompiledAction::Kind::Exec;
+    compiled.source = action;
+
+    auto argv = std::make_shared<WebDashType::CompiledAction::Argv>();
 
-        const auto tm_last  = gmtime(&_time_last);
-        const auto tm_today = gmtime(&_time_today);
+    std::istringstream iss(action);
+    argv->arguments.assign(std::istream_iterator<std::string>{iss}, std::istream_iterator<std::string>());
 
-        const int day_last  = tm_last->tm_mday;
-        const int day_today = tm_today->tm_mday;
+    for (auto& argument : argv->arguments)
+        argv->pointers.push_back(argument.data());
+
+    argv->pointers.push_back(NULL);
+
+    compiled.argv = std::move(argv);
+    return compiled;
+}
 
-        if (day_last != day_today) {
-            return true;
+
+void WebDashConfigTask::CompileActions(const unordered_set<string>& config_task_names) {
+    Definition& definition = MutableDefinition();
+    definition.compiled_actions.clear();
+
+    for (const auto& action : definition.actions) {
+        const bool is_single_word = !action.empty() &&
+                                    none_of(action.begin(), action.end(), [](unsigned char c) { return isspace(c); });
+
+        if (is_single_word && action[0] == ':') {
+            // Refers to a task of this config, independently of the config the execution was started from.
+            definition.compiled_actions.push_back({ WebDashType::CompiledAction::Kind::SubTask, action, nullptr,
+                                                    definition.config_path + action });
+        } else if (is_single_word && action.find(':') != string::npos) {
+            definition.compiled_actions.push_back({ WebDashType::CompiledAction::Kind::SubTask, action, nullptr, action });
+        } else if (is_single_word && config_task_names.count(action)) {
+            definition.compiled_actions.push_back({ WebDashType::CompiledAction::Kind::SubTask, action, nullptr,
+                                                    definition.config_path + ":" + action });
+        } else {
+            definition.compiled_actions.push_back(CompileExec(action));
         }
     }
 
+    for (auto& dependency : definition.dependencies) {
+        if (!dependency.empty() && dependency[0] == ':') {
+            dependency = definition.config_path + dependency;
+        } else if (config_task_names.count(dependency)) {
+            dependency = definition.config_path + ":" + dependency;
+        }
+    }
+}
 
-    return true;
+
+WebDashType::RunReturn WebDashConfigTask::Run(WebDashType::RunConfig config, std::string action) {
+    return RunExec(config, CompileExec(action));
 }
 
+
 // wsl.exe -- source ~/.profile && webdash install
-WebDashType::RunReturn WebDashConfigTask::Run(WebDashType::RunConfig config, std::string action) {
+WebDashType::RunReturn WebDashConfigTask::RunExec(const WebDashType::RunConfig& config,
+                                                  const WebDashType::CompiledAction& compiled) {
+
+    const Definition& definition = *_definition;
 
     WebDashType::RunReturn retval;
     _times_called++;
 
-    WebDash().Log(WebDashType::LogType::DEBUG, "Executing: " + this->_taskid);
+    const string& action = compiled.source;
+    const auto& execParts = compiled.argv->arguments;
+
+    WebDash().Log(WebDashType::LogType::DEBUG, "Executing: " + definition.taskid);
     WebDash().Log(WebDashType::LogType::DEBUG, "    => " + action);
 
-    cout << "Forking... " << endl;
+    /**
+     * The argv was prepared when the config was loaded; the banner is printed before launching. The executor runs
+     * tasks on several threads, so the child must not touch anything guarded by locks (stdio, logging, the
+     * allocator) that another thread might have held at the time of a fork.
+     */
 
-    int filedes[2];
-    // We create a pipe to be shared with two processes.
-    if (pipe(filedes) == -1)
-    {
-        perror("pipe");
-        exit(1);
+    if (execParts.empty()) {
+        WebDash().Log(WebDashType::LogType::ERR, "Empty action in task: " + definition.taskid);
+        retval.return_code = -1;
+        return retval;
     }
 
-    // Close pipe automatically after child done calling exec.
-    if (fcntl(filedes[0], F_SETFD, FD_CLOEXEC) == -1) {
-        perror("fcntl");
-        exit(1);
+    if (definition.wdir.has_value()) {
+        WebDash().Log(WebDashType::LogType::DEBUG, "Working directory set to: " + definition.wdir.value());
     }
 
-    const pid_t pid = fork();
-    if (pid == 0) {
+    /**
+     * The action ends at the earlier of its own timeout and the deadline of the whole execution. Nothing is started
+     * after the deadline passed or once the execution was cancelled.
+     */
 
-        /**
-         * Change the CWD if required by the task.
-         */
+    std::optional<std::chrono::steady_clock::time_point> deadline = config.deadline;
 
-        if (_wdir.has_value()) {
-            if (chdir(_wdir.value().c_str()) != 0) {
-                perror ("WebDashConfigTask::Run!chdir: Specified work directory does not exist?");
-                WebDash().Log(WebDashType::LogType::ERR, "Failed to set cwd to: " + _wdir.value());
-                exit(1);
-            }
+    if (definition.timeout.has_value()) {
+        const auto action_deadline = std::chrono::steady_clock::now() + definition.timeout.value();
+        deadline = deadline.has_value() ? min(deadline.value(), action_deadline) : action_deadline;
+    }
 
-            WebDash().Log(WebDashType::LogType::DEBUG, "Working directory set to: " + _wdir.value());
-        }
+    if (WebDashChildSupervisor::IsCancellationRequested()) {
+        WebDash().Log(WebDashType::LogType::INFO, "Cancelled, not starting: " + definition.taskid + " => " + action);
+        retval.return_code = -1;
+        retval.cancelled = true;
+        return retval;
+    }
 
-        std::istringstream iss(action.c_str());
+    if (config.deadline.has_value() && config.deadline.value() <= std::chrono::steady_clock::now()) {
+        WebDash().Log(WebDashType::LogType::WARN, "Deadline passed, not starting: " + definition.taskid + " => " + action);
+        retval.return_code = -1;
+        retval.timed_out = true;
+        return retval;
+    }
 
-        std::vector<std::string> execParts(std::istream_iterator<std::string>{iss},
-                                           std::istream_iterator<std::string>());
+    /**
+     * Cached actions are looked up by everything that determines their result. On a hit, the artifacts and the output
+     * are restored without launching anything. Otherwise, the output is recorded for the cache entry.
+     */
 
-        const char **paramList = new const char*[execParts.size() + 1];
+    std::optional<WebDashActionCache> cache;
 
-        for (unsigned int i = 0; i < execParts.size(); ++i)
-            paramList[i] = execParts[i].c_str();
+    if (definition.cache_results && config.use_action_cache) {
+        const auto base_directory = GetFingerprintBaseDirectory();
+        cache.emplace(WebDashActionCache::ComputeKey(action, definition.wdir, definition.inputs, base_directory), base_directory);
+    }
 
-        paramList[execParts.size()] = NULL;
+    // Captures the output if any of the config's output sinks is set (or for the cache).
+    WebDashOutputCapture capture(config, definition.taskid, _times_called,
+                                 cache.has_value() ? std::optional(cache->GetRecordPath()) : nullopt);
 
-        // child
-        cout << "\033[1;33m-----------------" << endl;
-        cout << "  TASKID: " << _taskid << endl;
-        cout << "  CWD:    " << std::filesystem::current_path() << endl;
-        cout << "  CALL:   `" << paramList[0];
-        for (unsigned int i = 1; i < execParts.size(); ++i) {
-            cout << " " << execParts[i];
-        }
-        cout << "`" << endl;
-        cout << "-----------------\033[0m" << endl;
-
-        {
-            // If we are to redirect output to a string, create a copy of filedes[1] to STDOUT_FILENO (standard output).
-            if (config.redirect_output_to_str) {
-                while ((dup2(filedes[1], STDOUT_FILENO) == -1) && (errno == EINTR)) {}
-                while ((dup2(filedes[1], STDERR_FILENO) == -1) && (errno == EINTR)) {}
-            }
+    if (cache.has_value() && cache->Restore(capture, retval)) {
+        WebDash().Log(WebDashType::LogType::INFO, "Restored from the action cache: " + definition.taskid + " => " + action);
+        return retval;
+    }
 
-            // Close now children copies. We don't need them. We only used them to share our standard output with filedes[1] (which parent still utilizes).
-            close(filedes[1]);
-            close(filedes[0]);
+    {
+        std::stringstream banner;
+        banner << "\033[1;33m-----------------" << endl;
+        banner << "  TASKID: " << definition.taskid << endl;
+        banner << "  CWD:    " << (definition.wdir.has_value() ? std::filesystem::path(definition.wdir.value()) : std::filesystem::current_path()) << endl;
+        banner << "  CALL:   `" << execParts[0];
+        for (unsigned int i = 1; i < execParts.size(); ++i) {
+            banner << " " << execParts[i];
         }
+        banner << "`" << endl;
+        banner << "-----------------\033[0m" << endl;
 
-        if (execvp(paramList[0], (char**)paramList) < 0) {
-            perror ("WebDashConfigTask::Run!execvp");
-        }
+        cout << "Launching... " << endl << banner.str();
+        cout.flush();
+    }
 
-        exit(1);
+    const auto launch_time = std::chrono::steady_clock::now();
+    const pid_t pid = WebDashProcessLauncher::Get(config.launcher).Launch(compiled.argv->pointers, definition.wdir, capture.GetChildFd());
+    const int launch_errno = errno;
 
-    } else if (pid > 0) {
-        close(filedes[1]);
+    capture.CloseChildFd();
 
-        // parent
-        if (config.redirect_output_to_str) {
+    if (pid < 0) {
+        WebDash().Log(WebDashType::LogType::ERR, "Failed to launch `" + action + "` of " + definition.taskid + ": " + strerror(launch_errno));
+        cerr << "WebDashConfigTask::Run!launch: " << strerror(launch_errno) << endl;
 
-            retval.output = "";
+        retval.return_code = -1;
 
-            while (1) {
-                char buffer[43];
-                int len = read(filedes[0], buffer, 42);
-                if ( len < 0 ) {
-                    if (errno == EINTR) {
-                        continue;
-                    }
-                    else {
-                        perror("read");
-                        close(filedes[0]);
-                        exit(1);
-                    }
-                }
-                else if ( len == 0 ) {
-                    break;
-                }
-                else {
-                    std::string data(buffer, len);
-                    retval.output += data;
-                }
-            }
+        if (cache.has_value()) {
+            cache->Store(retval.return_code, definition.outputs);
         }
-
-        close(filedes[0]);
+        return retval;
     }
 
     /**
      * Wait for child to finish before exiting. Return the object containing the
-     * processing result (e.g., status code of executed processes).
+     * processing result (e.g., status code of executed processes). The supervisor drains the output and reaps the
+     * child in its event loop; without pidfd support, both happen on this thread.
      */
 
     int status;
-    const pid_t wpid = waitpid(pid, &status, 0);
+    struct rusage usage;
+
+    if (auto child_exit = WebDashChildSupervisor::Get().WaitFor(pid, &capture, &retval, deadline)) {
+        status = child_exit->status;
+        usage = child_exit->usage;
+        retval.timed_out = child_exit->timed_out;
+        retval.cancelled = child_exit->cancelled;
+    } else {
+        // Without pidfds, the child is polled on this thread; the deadline and cancellation still apply.
+        const auto polled_exit = WebDashChildSupervisor::WaitPolling(pid, &capture, &retval, deadline);
+        status = polled_exit.status;
+        usage = polled_exit.usage;
+        retval.timed_out = polled_exit.timed_out;
+        retval.cancelled = polled_exit.cancelled;
+    }
+
+    // A child that could not be reaped has the status -1 (and no usage).
+    retval.return_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+    if (retval.timed_out || retval.cancelled) {
+        WebDash().Log(WebDashType::LogType::ERR, string(retval.timed_out ? "Timed out: " : "Cancelled: ") + definition.taskid + " => " + action);
+
+        // Even if the action handled the signal gracefully.
+        if (retval.return_code == 0) retval.return_code = -1;
+    }
+
+    retval.resource_usage = ToResourceUsage(usage, std::chrono::steady_clock::now() - launch_time);
+    retval.action_resource_usage.push_back({ definition.taskid, action, retval.resource_usage });
+
+    WebDash().Log(WebDashType::LogType::DEBUG, "Resources of " + definition.taskid + " => " + action + ": " +
+                                               FormatResourceUsage(retval.resource_usage));
+
+    if (cache.has_value()) {
+        cache->Store(retval.return_code, definition.outputs);
+    }
 
-    retval.return_code = wpid == pid &&
-                            WIFEXITED(status) ? WEXITSTATUS(status) : -1;
     return retval;
 }
 
 
+bool WebDashConfigTask::BeginRun(WebDashType::RunConfig config) {
+
+    const Definition& definition = *_definition;
+
+    if (!ShouldExecuteTimewise(config)) {
+        LogNotDue();
+        return false;
+    }
+
+    _print_skip_has_happened = false;
+    _last_exec_time = std::chrono::high_resolution_clock::now();
+    _next_due_time_computed = false;
+
+    if (HasTimeProperties()) {
+        // Also marks the time as loaded; a later lookup would only return the same.
+        _last_exec_time_loaded = true;
+        WebDashLastRuns::Get().Record(definition.taskid, ToSystemTime(_last_exec_time));
+    }
+
+    if (definition.notify_dashboard) {
+        IWebDash::Notify(definition.taskid);
+    }
+
+    return true;
+}
+
+
+void WebDashConfigTask::LogNotDue() {
+
+    if (_print_skip_has_happened)
+        return;
+
+    _print_skip_has_happened = true;
+
+    // E.g., tasks without `frequency` while only those are run.
+    if (!HasTimeProperties()) {
+        WebDash().Log(WebDashType::LogType::DEBUG, "Skipping: " + _definition->taskid);
+        return;
+    }
+
+    string next_due = "never";
+    const auto next_due_time = GetNextDueTime();
+
+    if (next_due_time.has_value()) {
+        const time_t time = std::chrono::system_clock::to_time_t(ToSystemTime(next_due_time.value()));
+        stringstream formatted;
+        formatted << put_time(localtime(&time), "%F %T");
+        next_due = formatted.str();
+    }
+
+    WebDash().Log(WebDashType::LogType::INFO, "Skipping " + _definition->taskid + ": not due before " + next_due +
+                                              " (frequency/when). Use --force to run it anyway.");
+    WebDash().Log(WebDashType::LogType::DEBUG, "....ommitting further similar reports until next execution passed.");
+}
+
+
 WebDashType::RunReturn WebDashConfigTask::Run(WebDashType::RunConfig config) {
 
+    const Definition& definition = *_definition;
+
     WebDashType::RunReturn ret;
 
-    if (!ShouldExecuteTimewise(config)) {
-        if (_print_skip_has_happened == false)
-        {
-            WebDash().Log(WebDashType::LogType::DEBUG, "Skipping: " + this->_taskid);
-            WebDash().Log(WebDashType::LogType::DEBUG, "Was executed XYZ milliseconds ago.");
-            WebDash().Log(WebDashType::LogType::DEBUG, "....ommitting further similar reports until next execution passed.");
-            _print_skip_has_happened = true;
+    /**
+     * Within one invocation, a task shared by several dependents (e.g., a common library) runs only once. Later
+     * callers receive the task's own result from the first execution.
+     */
+
+    if (config.memo) {
+        auto memoized = config.memo->Claim(definition.taskid);
+
+        if (memoized.has_value()) {
+            WebDash().Log(WebDashType::LogType::DEBUG, "Already executed during this invocation: " + definition.taskid);
+            return memoized.value();
         }
+    }
 
+    if (!BeginRun(config)) {
+        if (config.memo) config.memo->Complete(definition.taskid, ret);
         return ret;
     }
 
-    _print_skip_has_happened = false;
-    _last_exec_time = std::chrono::high_resolution_clock::now();
+    try {
+        RunDependenciesAndActions(config, ret);
+    } catch (...) {
+        if (config.memo) {
+            WebDashType::RunReturn failed;
+            failed.return_code = -1;
+            config.memo->Complete(definition.taskid, failed);
+        }
 
-    if (_notify_dashboard) {
-        IWebDash::Notify(_taskid);
+        throw;
     }
 
-    for (int i = 0; i < (int)_dependencies.size(); ++i) {
-        auto task = config.TaskRetriever(_dependencies[i]);
+    return ret;
+}
+
+
+void WebDashConfigTask::RunDependenciesAndActions(WebDashType::RunConfig config, WebDashType::RunReturn& ret) {
+
+    const Definition& definition = *_definition;
+
+    for (int i = 0; i < (int)definition.dependencies.size(); ++i) {
+        auto task = config.TaskRetriever(definition.dependencies[i]);
 
         if (task.has_value()) {
-            auto ret_sub = task.value().Run(config);
-            ret.output += ret_sub.output;
-            ret.return_code |= ret_sub.return_code;
+            ret.Append(task.value().Run(config));
+
+            // As in WebDashDagExecutor, a failed dependency blocks the task unless it continues on error.
+            if (ret.return_code && !definition.continue_on_error) {
+                WebDash().Log(WebDashType::LogType::INFO, "Not executed due to a failed dependency: " + definition.taskid);
+
+                if (config.memo) {
+                    WebDashType::RunReturn own;
+                    own.return_code = ret.return_code;
+                    config.memo->Complete(definition.taskid, own);
+                }
 
-            if (ret.return_code && _continue_on_error) {
-                return ret;
+                return;
             }
         }
     }
 
-    for (int i = 0; i < (int)_actions.size(); ++i) {
+    auto ret_actions = RunActions(config);
+
+    if (config.memo) config.memo->Complete(definition.taskid, ret_actions);
+
+    ret.Append(std::move(ret_actions));
+}
+
+
+WebDashType::RunReturn WebDashConfigTask::RunActions(WebDashType::RunConfig config) {
+
+    const Definition& definition = *_definition;
+
+    WebDashType::RunReturn ret;
+
+    /**
+     * Tasks declaring their inputs are skipped if nothing changed since their last successful run. The fingerprint is
+     * taken before the actions run, so that inputs modified during the run trigger another run next time.
+     */
+
+    std::optional<string> fingerprint;
+
+    if (!definition.inputs.empty()) {
+        const auto base_directory = GetFingerprintBaseDirectory();
+        fingerprint = WebDashFingerprint::ComputeInputFingerprint(definition.inputs, base_directory, definition.fingerprint_contents);
+
+        if (!config.ignore_fingerprints &&
+            WebDashFingerprintStore::Get().Lookup(definition.taskid) == fingerprint &&
+            WebDashFingerprint::OutputsExist(definition.outputs, base_directory)) {
+            WebDash().Log(WebDashType::LogType::INFO, "Up to date: " + definition.taskid);
+            return ret;
+        }
+    }
+
+    WebDashOutputCapture::ResetLog(config, definition.taskid);
 
-        const string action = _actions[i];
-        auto maybesubtask = config.TaskRetriever(action);
+    for (const auto& action : definition.compiled_actions) {
 
-        if (maybesubtask.has_value()) {
-            auto ret_sub = maybesubtask.value().Run(config);
-            ret.output += ret_sub.output;
-            ret.return_code |= ret_sub.return_code;
+        if (action.kind == WebDashType::CompiledAction::Kind::SubTask) {
+            auto subtask = config.TaskRetriever(action.reference);
+
+            if (subtask.has_value()) {
+                ret.Append(subtask.value().Run(config));
+            } else {
+                // Not a task after all (e.g., `C:\tools\x.exe` or `host:port`); executed as a command, as it is
+                // spelled.
+                WebDash().Log(WebDashType::LogType::DEBUG, "No task " + action.reference + "; executing: " + action.source);
+                ret.Append(RunExec(config, CompileExec(action.source)));
+            }
         }
         else {
-            auto ret_sub = Run(config, action);
-            ret.output += ret_sub.output;
-            ret.return_code |= ret_sub.return_code;
+            ret.Append(RunExec(config, action));
         }
 
-        if (ret.return_code && !_continue_on_error) {
+        if (ret.return_code && !definition.continue_on_error) {
             return ret;
         }
     }
 
+    if (fingerprint.has_value() && ret.return_code == 0) {
+        WebDashFingerprintStore::Get().Store(definition.taskid, fingerprint.value());
+    }
+
     return ret;
 }
+
+
+bool WebDashConfigTask::IsUpToDate(const WebDashType::RunConfig& config) const {
+    const Definition& definition = *_definition;
+
+    if (definition.inputs.empty() || config.ignore_fingerprints) {
+        return false;
+    }
+
+    const auto base_directory = GetFingerprintBaseDirectory();
+
+    return WebDashFingerprintStore::Get().Lookup(definition.taskid) ==
+               WebDashFingerprint::ComputeInputFingerprint(definition.inputs, base_directory, definition.fingerprint_contents) &&
+           WebDashFingerprint::OutputsExist(definition.outputs, base_directory);
+}
+
+
+std::filesystem::path WebDashConfigTask::GetFingerprintBaseDirectory() const {
+    if (_definition->wdir.has_value()) {
+        return _definition->wdir.value();
+    }
+
+    return std::filesystem::path(_definition->config_path).parent_path();
+}
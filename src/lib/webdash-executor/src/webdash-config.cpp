@@ -1,11 +1,19 @@
 #include "webdash-utils.hpp"
 #include "webdash-config.hpp"
+#include "webdash-config-cache.hpp"
+#include "webdash-config-index.hpp"
 #include "webdash-types.hpp"
 #include "webdash-core.hpp"
+#include "webdash-dag-executor.hpp"
+#include "webdash-run-memo.hpp"
 
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <unordered_map>
+#include <unordered_set>
 #include <nlohmann/json.hpp>
 using namespace std;
 
@@ -51,7 +59,14 @@ namespace {
 
 
 WebDashConfig::WebDashConfig(const std::filesystem::path config_filepath) {
-    auto canonical_config_filepath = std::filesystem::canonical(config_filepath);
+    std::error_code error;
+    auto canonical_config_filepath = std::filesystem::canonical(config_filepath, error);
+
+    if (error) {
+        WebDash().Log(WebDashType::LogType::DEBUG, "No WebDash config file: " + config_filepath.string() + ". Reason: " + error.message());
+        _loading_failed = true;
+        return;
+    }
 
     const auto& previous_config_filepath = _config_filepath;
     _config_filepath = canonical_config_filepath;
@@ -60,7 +75,7 @@ WebDashConfig::WebDashConfig(const std::filesystem::path config_filepath) {
 
     if (computed_tasks) {
         _loading_failed = false;
-        _tasks = computed_tasks.value();
+        SetTasks(std::move(computed_tasks.value()));
     } else {
         _loading_failed = true;
         _config_filepath = previous_config_filepath;
@@ -71,62 +86,139 @@ WebDashConfig::WebDashConfig(const std::filesystem::path config_filepath) {
 std::optional<vector<WebDashConfigTask>> WebDashConfig::LoadAndCheckKnownFailures(
     const std::filesystem::path& config_filepath)
 {
-    try {
-        return Load(config_filepath);
-    }
-    catch (const WebDashException::ConfigJsonParseError& e) {
-        WebDash().Log(WebDashType::LogType::DEBUG, "Not a valid WebDash config file: " + config_filepath.string() + ". Reason: " + e.what());
-        return nullopt;
+    string failure_reason;
+    auto tasks = Load(config_filepath, failure_reason);
+
+    if (!tasks.has_value()) {
+        WebDash().Log(WebDashType::LogType::DEBUG, "Not a valid WebDash config file: " + config_filepath.string() + ". Reason: " + failure_reason);
+        WebDashConfigIndex::Get().RecordLoadFailure(config_filepath);
     }
 
-    return nullopt;
+    return tasks;
 }
 
 
-vector<WebDashConfigTask> WebDashConfig::Load(const std::filesystem::path config_filepath) {
+std::optional<vector<WebDashConfigTask>> WebDashConfig::Load(const std::filesystem::path config_filepath,
+                                                             string& failure_reason) {
     vector<WebDashConfigTask> tasks;
 
-    ifstream configStream;
-    try {
-        configStream.open(config_filepath.c_str(), ifstream::in);
+    /**
+     * An unchanged config is restored from its compiled image; otherwise, the JSON is parsed and the image rewritten.
+     */
+
+    const auto cache_key = WebDashConfigCache::ComputeKey(config_filepath, GetProfileConfigSubtitutions());
+
+    if (cache_key.has_value()) {
+        if (auto cached_tasks = WebDashConfigCache::Load(config_filepath, cache_key.value())) {
+            WebDash().Log(WebDashType::LogType::DEBUG, "Commands loaded from the compiled config. Available count: " + to_string(cached_tasks->size()));
+
+            tasks = std::move(cached_tasks.value());
+            CompileActions(tasks);
+            RecordInIndex(config_filepath, tasks);
+            return tasks;
+        }
     }
-    catch (...) {
-        throw WebDashException::ConfigJsonParseError("Failed to open the config file.");
+
+    // Malformed configs are reported through `failure_reason`, as probing directories commonly runs into them.
+    ifstream configStream(config_filepath.c_str(), ifstream::in);
+    if (!configStream.is_open()) {
+        failure_reason = "Failed to open the config file.";
+        return nullopt;
     }
 
-    json json_config;
-    try {
-        configStream >> json_config;
-    } catch (...) {
-        throw WebDashException::ConfigJsonParseError("Unable to parse as JSON. Format error?");
+    const json json_config = json::parse(configStream, nullptr, /* allow_exceptions = */ false);
+    if (json_config.is_discarded()) {
+        failure_reason = "Unable to parse as JSON. Format error?";
+        return nullopt;
     }
 
-    json json_commands;
-    try {
-        json_commands = json_config["commands"];
-    } catch (...) {
-        throw WebDashException::ConfigJsonParseError("Failed to parse the 'commands' key. Exists?");
+    if (!json_config.is_object()) {
+        failure_reason = "Failed to parse the 'commands' key. Exists?";
+        return nullopt;
     }
 
+    const json json_commands = json_config.contains("commands") ? json_config["commands"] : json();
+
     WebDash().Log(WebDashType::LogType::DEBUG, "Commands loaded. Available count: " + to_string(json_commands.size()));
 
     int command_index = 0;
 
     for (auto json_command : json_commands) {
+        if (!json_command.is_object() || !json_command.contains("name") || !json_command["name"].is_string()) {
+            WebDash().Log(WebDashType::LogType::DEBUG, "Failed getting name from " + to_string(command_index) + "th command. Ignored.");
+            command_index++;
+            continue;
+        }
+
         try {
             const string command_identifier = config_filepath.string() + "#" + json_command["name"].get<std::string>();
             tasks.emplace_back(this, command_identifier, json_command);
         } catch (...) {
-            WebDash().Log(WebDashType::LogType::DEBUG, "Failed getting name from " + to_string(command_index) + "th command. Ignored.");
+            WebDash().Log(WebDashType::LogType::DEBUG, "Failed constructing the " + to_string(command_index) + "th command. Ignored.");
         }
 
         command_index++;
     }
 
+    CompileActions(tasks);
+
+    if (cache_key.has_value()) {
+        WebDashConfigCache::Store(config_filepath, cache_key.value(), tasks);
+    }
+
+    RecordInIndex(config_filepath, tasks);
     return tasks;
 }
 
 
+/* static */ void WebDashConfig::RecordInIndex(const std::filesystem::path& config_filepath,
+                                              const vector<WebDashConfigTask>& tasks) {
+    vector<string> task_names;
+    for (const auto& task : tasks) {
+        task_names.push_back(task.GetName());
+    }
+
+    WebDashConfigIndex::Get().Record(config_filepath, task_names);
+}
+
+
+/* static */ void WebDashConfig::CompileActions(vector<WebDashConfigTask>& tasks) {
+    // Actions are compiled once all task names are known, as an action may refer to any task of the config.
+    unordered_set<string> task_names;
+    for (auto& task : tasks) {
+        task_names.insert(task.GetName());
+    }
+
+    for (auto& task : tasks) {
+        task.CompileActions(task_names);
+    }
+}
+
+
+void WebDashConfig::SetTasks(vector<WebDashConfigTask> tasks) {
+    _tasks = std::move(tasks);
+    _task_indices.clear();
+    _task_indices.reserve(_tasks.size());
+
+    for (size_t i = 0; i < _tasks.size(); ++i) {
+        if (!_task_indices.emplace(_tasks[i].GetName(), i).second) {
+            WebDash().Log(WebDashType::LogType::WARN, "Duplicate task name in " + _config_filepath.string() + ": " + _tasks[i].GetName() + ". Only the first is used.");
+        }
+    }
+}
+
+
+WebDashConfigTask* WebDashConfig::FindTask(const string& command_name) {
+    auto task_index = _task_indices.find(command_name.empty() ? "all" : command_name);
+
+    if (task_index == _task_indices.end()) {
+        return nullptr;
+    }
+
+    return &_tasks[task_index->second];
+}
+
+
 string WebDashConfig::GetPath() const {
     return _config_filepath;
 }
@@ -157,7 +249,7 @@ void WebDashConfig::Reload() {
 
     if (computed_tasks) {
         _loading_failed = false;
-        _tasks = computed_tasks.value();
+        SetTasks(std::move(computed_tasks.value()));
     } else {
         _loading_failed = true;
     }
@@ -167,7 +259,9 @@ void WebDashConfig::Reload() {
 vector<string> WebDashConfig::GetTaskList() {
     vector<string> ret;
 
-    for (auto task : _tasks) {
+    ret.reserve(_tasks.size());
+
+    for (const auto& task : _tasks) {
         ret.push_back(task.GetName());
     }
 
@@ -176,15 +270,13 @@ vector<string> WebDashConfig::GetTaskList() {
 
 
 std::optional<WebDashConfigTask> WebDashConfig::GetTask(const string command_name) {
-    for (auto task : _tasks) {
-        if (task.GetName() == command_name) {
-            return task;
-        } else if (command_name == "" && task.GetName() == "all") {
-            return task;
-        }
+    const WebDashConfigTask* task = FindTask(command_name);
+
+    if (task == nullptr) {
+        return nullopt;
     }
 
-    return nullopt;
+    return *task;
 }
 
 
@@ -211,6 +303,9 @@ std::vector<WebDashType::RunReturn> WebDashConfig::Run(const string command_name
         // The case where the
          if (webdash_command_arg[0] == ':') {
             return GetTask(webdash_command_arg.substr(1));
+        } else if (ParseArgumentForPathWithCommandPrecedence(webdash_command_arg) == _config_filepath.string()) {
+            // Compiled references into this config (see WebDashConfigTask::CompileActions) need no reload.
+            return GetTask(webdash_command_arg.substr(_config_filepath.string().size() + 1));
         } else {
             try {
                 vector<string> arguments;
@@ -230,17 +325,16 @@ std::vector<WebDashType::RunReturn> WebDashConfig::Run(const string command_name
         return nullopt;
     };
 
-    for (WebDashConfigTask& task : _tasks) {
-        if (!task.IsValid()) {
-            continue;
-        }
+    // Every task runs at most once per invocation, no matter how many dependents share it.
+    if (!runconfig.memo) {
+        runconfig.memo = std::make_shared<WebDashRunMemo>();
+    }
 
-        // If a specific command name was given, only run that one. Otherwise, find the "all" command and only run that.
-        if (task.GetName() == command_name) {
-            ret.push_back(task.Run(runconfig));
-        } else if (command_name == "" && task.GetName() == "all") {
-            ret.push_back(task.Run(runconfig));
-        }
+    // If a specific command name was given, only run that one. Otherwise, find the "all" command and only run that.
+    WebDashConfigTask* task = FindTask(command_name);
+
+    if (task != nullptr && task->IsValid()) {
+        ret.push_back(WebDashDagExecutor(runconfig).Run(*task));
     }
 
     return ret;
@@ -276,10 +370,14 @@ inline std::optional<WebDashConfig> GetBestMatchingConfig(const std::filesystem:
         go_up_index <= /*random MAX value*/ 30;
         go_up_index++) {
 
-        std::filesystem::path fs_config_path = current_directory.string() + "/webdash.config.json";
+        // A stat per directory; only an existing config that did not fail to load before is loaded (from its
+        // compiled image, if unchanged).
+        auto fs_config_path = WebDashConfigIndex::Get().FindConfigInDirectory(current_directory);
 
-        auto tconfig = WebDashConfig(fs_config_path);
-        if (tconfig.LastLodingSucceeded()) return tconfig;
+        if (fs_config_path.has_value()) {
+            auto tconfig = WebDashConfig(fs_config_path.value());
+            if (tconfig.LastLodingSucceeded()) return tconfig;
+        }
 
         if (current_directory == current_directory.root_directory()) break;
         current_directory = current_directory.parent_path();
@@ -376,3 +474,134 @@ std::optional<ConfigAndCommand> GetConfigAndCommand(const vector<string>& argume
 
     return nullopt;
 }
+
+
+namespace {
+
+    /**
+     * @brief Creates a RunConfig::TaskRetriever that resolves references like GetConfigAndCommand, but loads each
+     *        config only once. Configs are found by the path as spelled in the reference and by their canonical path,
+     *        which qualified references (see WebDashConfigTask::CompileActions) use. Safe to call from several threads.
+     */
+    std::function<std::optional<WebDashConfigTask>(string)> CreateSharedConfigTaskRetriever() {
+        struct LoadedConfigs {
+            std::mutex mutex;
+            unordered_map<string, shared_ptr<WebDashConfig>> by_path;
+        };
+
+        auto loaded_configs = std::make_shared<LoadedConfigs>();
+
+        return [loaded_configs](const string webdash_command_arg) -> optional<WebDashConfigTask> {
+            lock_guard<mutex> lock(loaded_configs->mutex);
+
+            const auto path = ParseArgumentForPathWithCommandPrecedence(webdash_command_arg);
+
+            if (path.has_value()) {
+                auto loaded = loaded_configs->by_path.find(path.value());
+
+                if (loaded != loaded_configs->by_path.end()) {
+                    return loaded->second->GetTask(ParseArgumentForCommandWithPathPrecedence(webdash_command_arg).value_or("all"));
+                }
+            }
+
+            try {
+                vector<string> arguments;
+                arguments.push_back(webdash_command_arg);
+                auto config_and_command = GetConfigAndCommand(arguments);
+
+                if (!config_and_command)
+                    return nullopt;
+
+                auto config = std::make_shared<WebDashConfig>(std::move(config_and_command->first));
+                loaded_configs->by_path[config->GetPath()] = config;
+                if (path.has_value()) loaded_configs->by_path[path.value()] = config;
+
+                return config->GetTask(config_and_command->second);
+            } catch (...) {
+                WebDash().Log(WebDashType::LogType::DEBUG, "Not a WebDash task (" + webdash_command_arg + ")");
+                return nullopt;
+            }
+        };
+    }
+
+
+    /**
+     * @brief Resolves the targets through runconfig.TaskRetriever.
+     * @param tasks Receives the valid tasks. Reserved upfront, as the executor references them.
+     * @param task_target_indices Receives the index of the target of each of the tasks.
+     * @returns The indices of the targets that could not be resolved to a valid task.
+     */
+    vector<size_t> ResolveTargets(const vector<string>& targets, const WebDashType::RunConfig& runconfig,
+                                  vector<WebDashConfigTask>& tasks, vector<size_t>& task_target_indices) {
+        vector<size_t> unresolved_target_indices;
+        tasks.reserve(targets.size());
+
+        for (size_t i = 0; i < targets.size(); ++i) {
+            auto task = runconfig.TaskRetriever(targets[i]);
+
+            if (!task.has_value() || !task->IsValid()) {
+                WebDash().Log(WebDashType::LogType::ERR, "No valid task found for target: " + targets[i]);
+                unresolved_target_indices.push_back(i);
+                continue;
+            }
+
+            tasks.push_back(std::move(task.value()));
+            task_target_indices.push_back(i);
+        }
+
+        return unresolved_target_indices;
+    }
+
+
+    vector<WebDashConfigTask*> GetTaskPointers(vector<WebDashConfigTask>& tasks) {
+        vector<WebDashConfigTask*> task_pointers;
+
+        for (auto& task : tasks) {
+            task_pointers.push_back(&task);
+        }
+
+        return task_pointers;
+    }
+
+} // namespace
+
+
+std::vector<WebDashType::RunReturn> RunTargets(const vector<string>& targets, WebDashType::RunConfig runconfig) {
+    runconfig.TaskRetriever = CreateSharedConfigTaskRetriever();
+
+    // Every task runs at most once per invocation, no matter how many targets and dependents share it.
+    if (!runconfig.memo) {
+        runconfig.memo = std::make_shared<WebDashRunMemo>();
+    }
+
+    std::vector<WebDashType::RunReturn> ret(targets.size());
+
+    vector<WebDashConfigTask> tasks;
+    vector<size_t> task_target_indices;
+
+    for (size_t unresolved : ResolveTargets(targets, runconfig, tasks, task_target_indices)) {
+        ret[unresolved].return_code = 1;
+    }
+
+    auto task_rets = WebDashDagExecutor(runconfig).Run(GetTaskPointers(tasks));
+
+    for (size_t i = 0; i < task_rets.size(); ++i) {
+        ret[task_target_indices[i]] = std::move(task_rets[i]);
+    }
+
+    return ret;
+}
+
+
+std::optional<WebDashType::ExecutionPlan> PlanTargets(const vector<string>& targets, WebDashType::RunConfig runconfig) {
+    runconfig.TaskRetriever = CreateSharedConfigTaskRetriever();
+
+    vector<WebDashConfigTask> tasks;
+    vector<size_t> task_target_indices;
+
+    if (!ResolveTargets(targets, runconfig, tasks, task_target_indices).empty()) {
+        return nullopt;
+    }
+
+    return WebDashDagExecutor(runconfig).Plan(GetTaskPointers(tasks));
+}
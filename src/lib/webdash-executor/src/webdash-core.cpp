@@ -319,6 +319,8 @@ void WebDashCore::LoadFromAppStorage(const string& filename,
 void WebDashCore::Log(const WebDashType::LogType type,
                       const std::string msg,
                       const bool keep_version_from_previous_execution) {
+    std::lock_guard<std::mutex> lock(_log_mutex);
+
     // Stores the current time for timestamping the log entries.
     std::string curr_time = "";
 
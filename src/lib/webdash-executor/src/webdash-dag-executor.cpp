@@ -0,0 +1,405 @@
+#include "webdash-dag-executor.hpp"
+#include "webdash-worker-pool.hpp"
+#include "webdash-run-memo.hpp"
+#include "webdash-timing-history.hpp"
+#include "webdash-core.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+
+using namespace std;
+
+
+WebDashDagExecutor::WebDashDagExecutor(WebDashType::RunConfig config) : _config(std::move(config)) {}
+
+
+bool WebDashDagExecutor::AddNode(WebDashTaskGraph::TaskHandle handle, WebDashConfigTask& task) {
+    auto node = make_unique<Node>();
+
+    // Tasks that already ran during this invocation are neither started nor expanded again.
+    if (_config.memo && _config.memo->Contains(task.GetTaskId())) {
+        node->should_run = false;
+    } else {
+        // Without side effects; the run is only begun once the graph turned out to be acyclic (see Run).
+        node->should_run = task.ShouldExecuteTimewise(_config);
+
+        if (_planning) {
+            node->up_to_date = node->should_run && task.IsUpToDate(_config);
+        } else if (!node->should_run) {
+            task.LogNotDue();
+        }
+    }
+
+    _nodes.push_back(std::move(node));
+
+    return _nodes[handle]->should_run;
+}
+
+
+void WebDashDagExecutor::BuildGraph(const vector<WebDashConfigTask*>& targets) {
+    _graph.Link(targets, _config, [this](WebDashTaskGraph::TaskHandle handle, WebDashConfigTask& task) {
+        return AddNode(handle, task);
+    });
+
+    // Tasks that only run in place are never modified by the workers; their copies need no further lookup. Scheduled
+    // tasks are retrieved as before, as a worker might be executing them at the same time.
+    auto retriever = _config.TaskRetriever;
+
+    _config.TaskRetriever = [this, retriever](const string reference) -> optional<WebDashConfigTask> {
+        const auto handle = _graph.Find(reference);
+
+        if (handle != WebDashTaskGraph::kNoTask && handle >= _graph.ScheduledCount()) {
+            return _graph.Task(handle);
+        }
+
+        return retriever(reference);
+    };
+}
+
+
+optional<string> WebDashDagExecutor::ReportCycle() const {
+    const auto cycle = _graph.FindCycle();
+
+    if (!cycle.has_value()) {
+        return nullopt;
+    }
+
+    const string report = "Dependency cycle: " + _graph.FormatPath(cycle.value());
+
+    // Nothing is executed, so the user would otherwise only see the failure.
+    WebDash().Log(WebDashType::LogType::ERR, report);
+    cerr << report << endl;
+
+    return report;
+}
+
+
+bool WebDashDagExecutor::LessCritical::operator()(size_t lhs, size_t rhs) const {
+    const auto& lhs_path = executor->_nodes[lhs]->critical_path;
+    const auto& rhs_path = executor->_nodes[rhs]->critical_path;
+
+    if (lhs_path != rhs_path) {
+        return lhs_path < rhs_path;
+    }
+
+    return lhs > rhs;
+}
+
+
+void WebDashDagExecutor::ComputeCriticalPaths() {
+    vector<bool> computed(_nodes.size(), false);
+
+    // The critical path of a node continues through its most critical dependent.
+    std::function<void(size_t)> compute = [&](size_t node_index) {
+        if (computed[node_index]) return;
+        computed[node_index] = true;
+
+        Node& node = *_nodes[node_index];
+
+        std::chrono::milliseconds longest_dependent_path{0};
+        for (size_t dependent : _graph.Dependents(node_index)) {
+            compute(dependent);
+            longest_dependent_path = max(longest_dependent_path, _nodes[dependent]->critical_path);
+        }
+
+        std::chrono::milliseconds duration{0};
+        if (node.should_run && !node.up_to_date) {
+            duration = WebDashTimingHistory::Get().EstimateDuration(_graph.Task(node_index).GetTaskId()).value_or(kUnknownDurationEstimate);
+        }
+
+        node.critical_path = duration + longest_dependent_path;
+    };
+
+    for (size_t i = 0; i < _nodes.size(); ++i) {
+        compute(i);
+    }
+}
+
+
+void WebDashDagExecutor::Schedule(const vector<size_t>& node_indices) {
+    // All nodes are queued before any job starts, so that the first job already chooses among all of them.
+    {
+        lock_guard<mutex> lock(_mutex);
+        for (size_t node_index : node_indices) {
+            _ready.push(node_index);
+        }
+    }
+
+    for (size_t i = 0; i < node_indices.size(); ++i) {
+        _pool->Submit([this]() { ExecuteMostCritical(); });
+    }
+}
+
+
+void WebDashDagExecutor::ExecuteMostCritical() {
+    size_t node_index;
+    {
+        lock_guard<mutex> lock(_mutex);
+
+        // There is one job per queued node.
+        node_index = _ready.top();
+        _ready.pop();
+    }
+
+    Execute(node_index);
+}
+
+
+void WebDashDagExecutor::Execute(size_t node_index) {
+    Node& node = *_nodes[node_index];
+
+    bool dependency_failed;
+    {
+        lock_guard<mutex> lock(_mutex);
+        dependency_failed = node.dependency_failed;
+    }
+
+    WebDashConfigTask& task = _graph.Task(node_index);
+    const string& taskid = task.GetTaskId();
+
+    // The task might have run already (or might be running right now) as a sub-task action of another task.
+    auto memoized = _config.memo ? _config.memo->Claim(taskid) : nullopt;
+
+    if (memoized.has_value()) {
+        node.result = memoized.value();
+    } else {
+        if (dependency_failed && !task.ContinuesOnError()) {
+            WebDash().Log(WebDashType::LogType::INFO, "Not executed due to a failed dependency: " + taskid);
+            node.result.return_code = 1;
+        } else if (node.should_run) {
+            try {
+                const auto start_time = std::chrono::system_clock::now();
+                const auto start_timestamp = std::chrono::steady_clock::now();
+
+                node.result = task.RunActions(_config);
+
+                const auto duration = std::chrono::steady_clock::now() - start_timestamp;
+
+                // Tasks that were up to date or restored from the cache say nothing about their usual duration.
+                if (node.result.resource_usage.process_count > 0) {
+                    WebDashTimingHistory::Get().Append(taskid, start_time,
+                        std::chrono::duration_cast<std::chrono::microseconds>(duration), node.result);
+                }
+            } catch (const std::exception& e) {
+                WebDash().Log(WebDashType::LogType::ERR, "Execution of " + taskid + " failed: " + e.what());
+                node.result.return_code = -1;
+            }
+        }
+
+        if (_config.memo) _config.memo->Complete(taskid, node.result);
+    }
+
+    const bool failed = node.result.return_code != 0;
+
+    vector<size_t> ready;
+    bool all_finished;
+    {
+        lock_guard<mutex> lock(_mutex);
+
+        for (size_t dependent : _graph.Dependents(node_index)) {
+            auto& dependent_node = *_nodes[dependent];
+            dependent_node.dependency_failed |= failed;
+
+            if (--dependent_node.pending_dependencies == 0) {
+                ready.push_back(dependent);
+            }
+        }
+
+        _finished_count++;
+        all_finished = _finished_count == _nodes.size();
+    }
+
+    Schedule(ready);
+
+    if (all_finished) {
+        _all_finished.notify_all();
+    }
+}
+
+
+WebDashType::RunReturn WebDashDagExecutor::CollectResults(size_t node_index, vector<bool>& collected) {
+    WebDashType::RunReturn ret;
+    vector<bool> visited(_nodes.size(), false);
+
+    std::function<void(size_t)> collect = [&](size_t node_index) {
+        if (visited[node_index]) return;
+        visited[node_index] = true;
+
+        for (size_t dependency : _graph.Dependencies(node_index)) {
+            collect(dependency);
+        }
+
+        // The status of a node counts for every target depending on it (or listed more than once)...
+        const auto& result = _nodes[node_index]->result;
+        ret.return_code |= result.return_code;
+        ret.timed_out |= result.timed_out;
+        ret.cancelled |= result.cancelled;
+
+        // ... while its output and resource usage are reported once only.
+        if (!collected[node_index]) {
+            collected[node_index] = true;
+            ret.Append(std::move(_nodes[node_index]->result));
+        }
+    };
+
+    collect(node_index);
+
+    return ret;
+}
+
+
+WebDashType::RunReturn WebDashDagExecutor::Run(WebDashConfigTask& target) {
+    return std::move(Run(vector<WebDashConfigTask*>{ &target }).front());
+}
+
+
+vector<WebDashType::RunReturn> WebDashDagExecutor::Run(const vector<WebDashConfigTask*>& targets) {
+    if (targets.empty()) {
+        return {};
+    }
+
+    BuildGraph(targets);
+
+    if (const auto cycle = ReportCycle()) {
+        vector<WebDashType::RunReturn> ret(targets.size());
+        for (auto& target_ret : ret) {
+            target_ret.return_code = 1;
+            target_ret.output = cycle.value() + "\n";
+        }
+        return ret;
+    }
+
+    // Records the execution times and notifies the dashboard.
+    for (size_t i = 0; i < _nodes.size(); ++i) {
+        if (_nodes[i]->should_run) {
+            _nodes[i]->should_run = _graph.Task(i).BeginRun(_config);
+        }
+    }
+
+    ComputeCriticalPaths();
+
+    vector<size_t> ready;
+
+    for (size_t i = 0; i < _nodes.size(); ++i) {
+        _nodes[i]->pending_dependencies = _graph.Dependencies(i).size();
+        if (_nodes[i]->pending_dependencies == 0) ready.push_back(i);
+    }
+
+    const size_t worker_count = min<size_t>(max(_config.concurrency, 1), _nodes.size());
+
+    WebDash().Log(WebDashType::LogType::DEBUG, "Executing " + to_string(_nodes.size()) + " task(s) of " +
+                                               to_string(targets.size()) + " target(s) with " + to_string(worker_count) + " worker(s).");
+
+    {
+        WebDashWorkerPool pool(worker_count);
+        _pool = &pool;
+
+        Schedule(ready);
+
+        unique_lock<mutex> lock(_mutex);
+        _all_finished.wait(lock, [this]() { return _finished_count == _nodes.size(); });
+    }
+
+    _pool = nullptr;
+
+    vector<WebDashType::RunReturn> ret;
+    vector<bool> collected(_nodes.size(), false);
+
+    for (size_t target_index : _graph.Targets()) {
+        ret.push_back(CollectResults(target_index, collected));
+    }
+
+    return ret;
+}
+
+
+WebDashType::PlannedTask WebDashDagExecutor::PlanTask(WebDashTaskGraph::TaskHandle handle) const {
+    WebDashConfigTask& task = _graph.Task(handle);
+    const bool is_scheduled = handle < _graph.ScheduledCount();
+
+    WebDashType::PlannedTask planned;
+    planned.taskid = task.GetTaskId();
+    planned.wdir = task.GetWorkingDirectory();
+    planned.actions = task.GetCompiledActions();
+    planned.estimated_duration = WebDashTimingHistory::Get().EstimateDuration(planned.taskid);
+
+    if (_config.memo && _config.memo->Contains(planned.taskid)) {
+        planned.skip_reason = "already executed";
+    } else if (!task.ShouldExecuteTimewise(_config)) {
+        planned.skip_reason = "not due (frequency/when)";
+    } else if (is_scheduled ? _nodes[handle]->up_to_date : task.IsUpToDate(_config)) {
+        // Scheduled tasks were already checked when they were linked (see AddNode).
+        planned.skip_reason = "up to date";
+    }
+
+    for (const auto dependency : _graph.Dependencies(handle)) {
+        planned.dependency_ids.push_back(_graph.Task(dependency).GetTaskId());
+    }
+
+    for (const auto subtask : _graph.SubTasks(handle)) {
+        planned.action_subtask_ids.push_back(subtask == WebDashTaskGraph::kNoTask ? "" : _graph.Task(subtask).GetTaskId());
+    }
+
+    if (is_scheduled) {
+        planned.critical_path = _nodes[handle]->critical_path;
+    }
+
+    return planned;
+}
+
+
+WebDashType::ExecutionPlan WebDashDagExecutor::Plan(const vector<WebDashConfigTask*>& targets) {
+    WebDashType::ExecutionPlan plan;
+
+    if (targets.empty()) {
+        return plan;
+    }
+
+    _planning = true;
+    BuildGraph(targets);
+
+    if (ReportCycle().has_value()) {
+        plan.acyclic = false;
+        return plan;
+    }
+
+    ComputeCriticalPaths();
+
+    vector<size_t> levels(_nodes.size(), 0);
+    vector<bool> computed(_nodes.size(), false);
+
+    std::function<size_t(size_t)> level_of = [&](size_t node_index) -> size_t {
+        if (!computed[node_index]) {
+            computed[node_index] = true;
+
+            for (size_t dependency : _graph.Dependencies(node_index)) {
+                levels[node_index] = max(levels[node_index], level_of(dependency) + 1);
+            }
+        }
+
+        return levels[node_index];
+    };
+
+    vector<size_t> order(_nodes.size());
+    iota(order.begin(), order.end(), 0);
+
+    for (size_t node_index : order) {
+        level_of(node_index);
+    }
+
+    stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return levels[lhs] < levels[rhs]; });
+
+    for (size_t node_index : order) {
+        plan.tasks.push_back(PlanTask(node_index));
+        plan.tasks.back().level = levels[node_index];
+    }
+
+    for (size_t handle = _graph.ScheduledCount(); handle < _graph.Size(); ++handle) {
+        plan.subtasks.push_back(PlanTask(handle));
+    }
+
+    return plan;
+}
@@ -0,0 +1,158 @@
+#include "webdash-fingerprint.hpp"
+#include "webdash-core.hpp"
+#include "webdash-utils.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <fstream>
+
+using namespace std;
+using json = nlohmann::json;
+
+
+namespace {
+
+    /**
+     * @returns The hash of the file's content, continued from the given seed.
+     */
+    uint64_t HashFileContent(const filesystem::path& path, uint64_t seed) {
+        ifstream stream(path, ios::binary);
+        vector<char> buffer(64 * 1024);
+
+        uint64_t hash = seed;
+        while (stream.read(buffer.data(), buffer.size()) || stream.gcount() > 0) {
+            hash = WebDashUtils::HashFnv1a(string_view(buffer.data(), stream.gcount()), hash);
+        }
+
+        return hash;
+    }
+
+} // namespace
+
+
+namespace WebDashFingerprint {
+
+    string ComputeInputFingerprint(const vector<string>& input_patterns,
+                                   const filesystem::path& base_directory,
+                                   bool hash_contents) {
+        uint64_t hash = WebDashUtils::HashFnv1a("");
+
+        for (const auto& pattern : input_patterns) {
+            hash = WebDashUtils::HashFnv1a(pattern + "\n", hash);
+
+            for (const auto& path : WebDashUtils::ExpandGlob(pattern, base_directory)) {
+                std::error_code error;
+
+                if (!filesystem::is_regular_file(path, error)) {
+                    continue;
+                }
+
+                const auto size = filesystem::file_size(path, error);
+                const auto mtime = filesystem::last_write_time(path, error).time_since_epoch();
+                const auto mtime_ns = chrono::duration_cast<chrono::nanoseconds>(mtime).count();
+
+                hash = WebDashUtils::HashFnv1a(path.string() + "|" + to_string(size) + "|" + to_string(mtime_ns) + "\n", hash);
+
+                if (hash_contents) {
+                    hash = HashFileContent(path, hash);
+                }
+            }
+        }
+
+        return WebDashUtils::ToHex(hash);
+    }
+
+
+    uint64_t HashInputContents(const vector<string>& input_patterns,
+                               const filesystem::path& base_directory,
+                               uint64_t seed) {
+        uint64_t hash = seed;
+
+        for (const auto& pattern : input_patterns) {
+            hash = WebDashUtils::HashFnv1a(pattern + "\n", hash);
+
+            for (const auto& path : WebDashUtils::ExpandGlob(pattern, base_directory)) {
+                std::error_code error;
+
+                if (!filesystem::is_regular_file(path, error)) {
+                    continue;
+                }
+
+                hash = WebDashUtils::HashFnv1a(path.lexically_relative(base_directory).string() + "\n", hash);
+                hash = HashFileContent(path, hash);
+            }
+        }
+
+        return hash;
+    }
+
+
+    bool OutputsExist(const vector<string>& output_patterns, const filesystem::path& base_directory) {
+        for (const auto& pattern : output_patterns) {
+            if (WebDashUtils::ExpandGlob(pattern, base_directory).empty()) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+} // namespace WebDashFingerprint
+
+
+/* static */ WebDashFingerprintStore& WebDashFingerprintStore::Get() {
+    static WebDashFingerprintStore store;
+    return store;
+}
+
+
+void WebDashFingerprintStore::LoadIfNeeded() {
+    if (_loaded) {
+        return;
+    }
+
+    _loaded = true;
+
+    WebDash().LoadFromAppStorage(kFingerprintsFilename, WebDashType::StorageReadType::JSON, [&](istream& stream) {
+        json content;
+        stream >> content;
+
+        _fingerprints.clear();
+        for (const auto& [taskid, fingerprint] : content.items()) {
+            _fingerprints[taskid] = fingerprint.get<string>();
+        }
+    });
+}
+
+
+std::optional<string> WebDashFingerprintStore::Lookup(const string& taskid) {
+    lock_guard<mutex> lock(_mutex);
+    LoadIfNeeded();
+
+    auto it = _fingerprints.find(taskid);
+    if (it == _fingerprints.end()) {
+        return nullopt;
+    }
+
+    return it->second;
+}
+
+
+void WebDashFingerprintStore::Store(const string& taskid, const string& fingerprint) {
+    lock_guard<mutex> lock(_mutex);
+    LoadIfNeeded();
+
+    _fingerprints[taskid] = fingerprint;
+
+    json content = json::object();
+    for (const auto& [id, value] : _fingerprints) {
+        content[id] = value;
+    }
+
+    WebDash().WriteToAppStorage(kFingerprintsFilename, [&](WebDashType::StoreWriteChannel writer) {
+        writer(WebDashType::StorageWriteType::Clear, "");
+        writer(WebDashType::StorageWriteType::Append, content.dump(4));
+        writer(WebDashType::StorageWriteType::End, "");
+    });
+}
@@ -0,0 +1,279 @@
+#include "webdash-last-runs.hpp"
+#include "webdash-core.hpp"
+#include "webdash-utils.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+namespace {
+
+    using Header = WebDashLastRuns::Header;
+    using Slot = WebDashLastRuns::Slot;
+
+    uint64_t SlotHash(const string& taskid) {
+        const uint64_t hash = WebDashUtils::HashFnv1a(taskid);
+        return hash == 0 ? 1 : hash;
+    }
+
+    size_t GetFileSize(uint32_t slot_count) {
+        return sizeof(Header) + static_cast<size_t>(slot_count) * sizeof(Slot);
+    }
+
+    Header* GetHeader(void* mapping) {
+        return static_cast<Header*>(mapping);
+    }
+
+    /**
+     * @returns The slot holding the hash, or the empty slot where it belongs. The table is never full.
+     */
+    Slot* Probe(void* mapping, uint64_t taskid_hash) {
+        Slot* slots = reinterpret_cast<Slot*>(static_cast<char*>(mapping) + sizeof(Header));
+        const uint32_t mask = GetHeader(mapping)->slot_count - 1;
+
+        for (uint32_t index = taskid_hash & mask;; index = (index + 1) & mask) {
+            const uint64_t slot_hash = std::atomic_ref<uint64_t>(slots[index].taskid_hash).load(std::memory_order_acquire);
+
+            if (slot_hash == 0 || slot_hash == taskid_hash) {
+                return &slots[index];
+            }
+        }
+    }
+
+    /**
+     * @brief Maps the given state file read-write.
+     * @returns The mapping; nullptr on failure.
+     */
+    void* MapFile(int fd, size_t size) {
+        void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        return mapping == MAP_FAILED ? nullptr : mapping;
+    }
+
+} // namespace
+
+
+/* static */ WebDashLastRuns& WebDashLastRuns::Get() {
+    static WebDashLastRuns last_runs;
+    return last_runs;
+}
+
+
+/* static */ std::filesystem::path WebDashLastRuns::GetStatePath() {
+    return WebDash().GetPersistenteAppStoragePath() / kStateFilename;
+}
+
+
+WebDashLastRuns::~WebDashLastRuns() {
+    Unmap();
+}
+
+
+void WebDashLastRuns::Unmap() {
+    if (_mapping) {
+        munmap(_mapping, _mapping_size);
+        _mapping = nullptr;
+        _mapping_size = 0;
+    }
+
+    if (_fd != -1) {
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+
+bool WebDashLastRuns::EnsureMapped() {
+    if (_mapping) {
+        if (std::atomic_ref<uint32_t>(GetHeader(_mapping)->moved).load(std::memory_order_acquire) == 0) {
+            return true;
+        }
+
+        Unmap();
+    }
+
+    const auto path = GetStatePath();
+
+    // The file might be replaced between opening and locking it; the replaced one is marked as moved.
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+        if (fd == -1) {
+            WebDash().Log(WebDashType::LogType::ERR, "Failed to open the last-run state " + path.string() + ": " + strerror(errno));
+            return false;
+        }
+
+        flock(fd, LOCK_EX);
+
+        struct stat file_stat;
+        Header header = {};
+        bool usable = fstat(fd, &file_stat) == 0;
+
+        if (usable && file_stat.st_size == 0) {
+            memcpy(header.magic, kMagic, sizeof(kMagic));
+            header.slot_count = kInitialSlotCount;
+
+            usable = ftruncate(fd, GetFileSize(header.slot_count)) == 0 &&
+                     pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+        } else if (usable) {
+            usable = file_stat.st_size >= static_cast<off_t>(sizeof(header)) &&
+                     pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                     memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                     file_stat.st_size >= static_cast<off_t>(GetFileSize(header.slot_count));
+        }
+
+        if (!usable) {
+            WebDash().Log(WebDashType::LogType::ERR, "Unusable last-run state: " + path.string());
+            flock(fd, LOCK_UN);
+            close(fd);
+            return false;
+        }
+
+        if (header.moved) {
+            flock(fd, LOCK_UN);
+            close(fd);
+            continue;
+        }
+
+        void* mapping = MapFile(fd, GetFileSize(header.slot_count));
+        flock(fd, LOCK_UN);
+
+        if (!mapping) {
+            WebDash().Log(WebDashType::LogType::ERR, "Failed to map the last-run state: " + string(strerror(errno)));
+            close(fd);
+            return false;
+        }
+
+        _fd = fd;
+        _mapping = mapping;
+        _mapping_size = GetFileSize(header.slot_count);
+        return true;
+    }
+
+    return false;
+}
+
+
+bool WebDashLastRuns::Grow() {
+    const Header& old_header = *GetHeader(_mapping);
+    const uint32_t slot_count = old_header.slot_count * 2;
+
+    const auto path = GetStatePath();
+    const auto new_path = path.string() + ".tmp." + to_string(getpid());
+
+    const int fd = open(new_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    void* mapping = fd != -1 && ftruncate(fd, GetFileSize(slot_count)) == 0 ? MapFile(fd, GetFileSize(slot_count)) : nullptr;
+
+    if (!mapping) {
+        WebDash().Log(WebDashType::LogType::ERR, "Failed to grow the last-run state: " + string(strerror(errno)));
+        if (fd != -1) close(fd);
+        unlink(new_path.c_str());
+        return false;
+    }
+
+    Header& header = *GetHeader(mapping);
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.slot_count = slot_count;
+    header.used_count = old_header.used_count;
+
+    const Slot* old_slots = reinterpret_cast<const Slot*>(static_cast<char*>(_mapping) + sizeof(Header));
+
+    for (uint32_t i = 0; i < old_header.slot_count; ++i) {
+        if (old_slots[i].taskid_hash != 0) {
+            *Probe(mapping, old_slots[i].taskid_hash) = old_slots[i];
+        }
+    }
+
+    // Processes that open the new file wait for this one to finish its update.
+    flock(fd, LOCK_EX);
+
+    if (rename(new_path.c_str(), path.c_str()) != 0) {
+        WebDash().Log(WebDashType::LogType::ERR, "Failed to replace the last-run state: " + string(strerror(errno)));
+        munmap(mapping, GetFileSize(slot_count));
+        close(fd);
+        unlink(new_path.c_str());
+        return false;
+    }
+
+    std::atomic_ref<uint32_t>(GetHeader(_mapping)->moved).store(1, std::memory_order_release);
+    flock(_fd, LOCK_UN);
+    Unmap();
+
+    _fd = fd;
+    _mapping = mapping;
+    _mapping_size = GetFileSize(slot_count);
+    return true;
+}
+
+
+std::optional<std::chrono::system_clock::time_point> WebDashLastRuns::Lookup(const string& taskid) {
+    lock_guard<mutex> lock(_mutex);
+
+    if (!EnsureMapped()) {
+        return nullopt;
+    }
+
+    const uint64_t taskid_hash = SlotHash(taskid);
+    Slot* slot = Probe(_mapping, taskid_hash);
+
+    if (std::atomic_ref<uint64_t>(slot->taskid_hash).load(std::memory_order_acquire) != taskid_hash) {
+        return nullopt;
+    }
+
+    const int64_t last_run_unix_ms = std::atomic_ref<int64_t>(slot->last_run_unix_ms).load(std::memory_order_relaxed);
+    return std::chrono::system_clock::time_point(std::chrono::milliseconds(last_run_unix_ms));
+}
+
+
+void WebDashLastRuns::Record(const string& taskid, std::chrono::system_clock::time_point time) {
+    lock_guard<mutex> lock(_mutex);
+
+    // Inserting needs the flock; another process might have replaced the file before it was acquired.
+    for (int attempt = 0;; ++attempt) {
+        if (attempt == 3 || !EnsureMapped()) {
+            return;
+        }
+
+        flock(_fd, LOCK_EX);
+
+        if (std::atomic_ref<uint32_t>(GetHeader(_mapping)->moved).load(std::memory_order_acquire) == 0) {
+            break;
+        }
+
+        flock(_fd, LOCK_UN);
+    }
+
+    const uint64_t taskid_hash = SlotHash(taskid);
+    Slot* slot = Probe(_mapping, taskid_hash);
+
+    if (slot->taskid_hash == 0) {
+        Header& header = *GetHeader(_mapping);
+
+        // At most three quarters of the slots are used, which keeps the probe sequences short.
+        if ((header.used_count + 1) * 4 > header.slot_count * 3) {
+            if (!Grow()) {
+                flock(_fd, LOCK_UN);
+                return;
+            }
+
+            slot = Probe(_mapping, taskid_hash);
+        }
+
+        GetHeader(_mapping)->used_count++;
+    }
+
+    // The time is in place before the slot becomes visible to readers of other processes.
+    const int64_t unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    std::atomic_ref<int64_t>(slot->last_run_unix_ms).store(unix_ms, std::memory_order_relaxed);
+    std::atomic_ref<uint64_t>(slot->taskid_hash).store(taskid_hash, std::memory_order_release);
+
+    flock(_fd, LOCK_UN);
+}
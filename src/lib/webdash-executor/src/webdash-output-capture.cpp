@@ -0,0 +1,365 @@
+#include "webdash-output-capture.hpp"
+#include "webdash-core.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+namespace {
+
+    /**
+     * @brief Writes the whole buffer, retrying on partial writes and interrupts.
+     */
+    void WriteAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            const ssize_t written = write(fd, data, size);
+
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+
+            data += written;
+            size -= written;
+        }
+    }
+
+    /**
+     * @returns The task id, usable as a file name.
+     */
+    string TaskIdToFilename(const string& taskid) {
+        string filename = taskid;
+
+        for (char& c : filename) {
+            if (!isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-' && c != '#') {
+                c = '_';
+            }
+        }
+
+        return filename;
+    }
+
+} // namespace
+
+
+WebDashTailBuffer::WebDashTailBuffer(size_t capacity) : _ring(capacity, '\0') {}
+
+
+void WebDashTailBuffer::Write(std::string_view data) {
+    const size_t capacity = _ring.size();
+
+    if (capacity == 0) {
+        _total_size += data.size();
+        return;
+    }
+
+    // Only the last `capacity` bytes of the data can survive.
+    const size_t skipped = data.size() > capacity ? data.size() - capacity : 0;
+    size_t position = (_total_size + skipped) % capacity;
+    _total_size += data.size();
+    data.remove_prefix(skipped);
+
+    while (!data.empty()) {
+        const size_t length = min(data.size(), capacity - position);
+        memcpy(_ring.data() + position, data.data(), length);
+        data.remove_prefix(length);
+        position = (position + length) % capacity;
+    }
+}
+
+
+string WebDashTailBuffer::ToString() const {
+    if (_total_size <= _ring.size()) {
+        return _ring.substr(0, _total_size);
+    }
+
+    const size_t oldest = _total_size % _ring.size();
+    return _ring.substr(oldest) + _ring.substr(0, oldest);
+}
+
+
+WebDashOutputCapture::WebDashOutputCapture(const WebDashType::RunConfig& config,
+                                           const string& taskid,
+                                           int action_index,
+                                           const std::optional<std::filesystem::path>& record_path) {
+    _taskid = taskid;
+    _action_index = action_index;
+    _collect_to_str = config.redirect_output_to_str;
+    _callback = config.output_callback;
+
+    if (_collect_to_str && config.output_tail_limit > 0) {
+        _tail.emplace(config.output_tail_limit);
+    }
+
+    const bool has_log = config.output_log_directory.has_value();
+
+    if (record_path.has_value()) {
+        _record_fd = open(record_path->c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+        if (_record_fd == -1) {
+            WebDash().Log(WebDashType::LogType::ERR, "Failed to open " + record_path->string() + ": " + strerror(errno));
+        } else if (!_collect_to_str && !_callback && !has_log) {
+            // The output would have gone to the terminal if it was not recorded.
+            _forward_fd = STDOUT_FILENO;
+        }
+    }
+
+    if (!_collect_to_str && !_callback && !has_log && _record_fd == -1) {
+        return;
+    }
+
+    int filedes[2];
+    // Both ends are closed automatically on exec, so that children spawned concurrently by other worker threads do
+    // not inherit (and keep open) our write end. The launcher duplicates the write end as the child's stdout/stderr.
+    if (pipe2(filedes, O_CLOEXEC) == -1) {
+        throw WebDashException::General(string("Failed to create the output pipe: ") + strerror(errno));
+    }
+
+    _read_fd = filedes[0];
+    _write_fd = filedes[1];
+
+    // Fewer, larger transfers for chatty children. Not fatal if the limit does not allow it.
+    fcntl(_read_fd, F_SETPIPE_SZ, kPipeSize);
+
+    if (has_log) {
+        const auto log_path = GetLogPath(config.output_log_directory.value(), taskid);
+        _log_fd = open(log_path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+
+        if (_log_fd == -1) {
+            WebDash().Log(WebDashType::LogType::ERR, "Failed to open the output log " + log_path.string() + ": " + strerror(errno));
+        } else {
+            // Not opened with O_APPEND, which splice() does not support. Actions of a task run one after another.
+            lseek(_log_fd, 0, SEEK_END);
+        }
+    }
+
+    _splice_to_log = _log_fd != -1 && !_collect_to_str && !_callback && _record_fd == -1;
+
+    if (!_collect_to_str || _tail.has_value()) {
+        _buffer.reset(new char[kReadChunkSize]);
+    }
+}
+
+
+WebDashOutputCapture::~WebDashOutputCapture() {
+    CloseChildFd();
+
+    if (_read_fd != -1) close(_read_fd);
+    if (_log_fd != -1) close(_log_fd);
+    if (_record_fd != -1) close(_record_fd);
+    if (_spill_fd != -1) close(_spill_fd);
+}
+
+
+void WebDashOutputCapture::CloseChildFd() {
+    if (_write_fd != -1) {
+        close(_write_fd);
+        _write_fd = -1;
+    }
+}
+
+
+void WebDashOutputCapture::Deliver(std::string_view chunk) {
+    if (_callback) {
+        _callback(_taskid, chunk);
+    }
+
+    if (_log_fd != -1) {
+        WriteAll(_log_fd, chunk.data(), chunk.size());
+    }
+
+    if (_record_fd != -1) {
+        WriteAll(_record_fd, chunk.data(), chunk.size());
+    }
+
+    if (_forward_fd != -1) {
+        WriteAll(_forward_fd, chunk.data(), chunk.size());
+    }
+}
+
+
+bool WebDashOutputCapture::ReadAvailable(WebDashType::RunReturn& ret) {
+    if (_read_fd == -1) {
+        return false;
+    }
+
+    while (true) {
+        ssize_t length;
+
+        if (_splice_to_log) {
+            length = splice(_read_fd, nullptr, _log_fd, nullptr, kPipeSize, SPLICE_F_MOVE);
+
+            // The log's file system does not support splicing. Copy through user space instead.
+            if (length < 0 && errno == EINVAL) {
+                _splice_to_log = false;
+                continue;
+            }
+        } else if (_collect_to_str && !_tail.has_value()) {
+            // Read straight into the tail of the collected output.
+            const size_t previous_size = ret.output.size();
+            ret.output.resize(previous_size + kReadChunkSize);
+            length = read(_read_fd, ret.output.data() + previous_size, kReadChunkSize);
+            ret.output.resize(previous_size + max<ssize_t>(length, 0));
+
+            if (length > 0) {
+                Deliver(std::string_view(ret.output).substr(previous_size));
+            }
+        } else {
+            length = read(_read_fd, _buffer.get(), kReadChunkSize);
+
+            if (length > 0) {
+                const std::string_view chunk(_buffer.get(), length);
+
+                if (_tail.has_value()) KeepTail(chunk);
+                Deliver(chunk);
+            }
+        }
+
+        if (length > 0) {
+            return true;
+        }
+
+        if (length == 0) {
+            FinishTail(ret);
+            return false;
+        }
+
+        if (errno == EINTR) {
+            continue;
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        }
+
+        WebDash().Log(WebDashType::LogType::ERR, "Failed to read the output of " + _taskid + ": " + strerror(errno));
+        FinishTail(ret);
+        return false;
+    }
+}
+
+
+void WebDashOutputCapture::KeepTail(std::string_view chunk) {
+
+    // First time over the limit: all output so far is still in the buffer. It starts the spill file.
+    if (!_spill_path.has_value() && _tail->GetTotalSize() + chunk.size() > _tail->GetCapacity()) {
+        // Runs on the supervisor thread, so nothing may throw (e.g., with a read-only or full app storage).
+        std::error_code error;
+        std::filesystem::path spill_directory;
+
+        try {
+            spill_directory = GetSpillDirectory();
+        } catch (const std::filesystem::filesystem_error& e) {
+            error = e.code();
+        }
+
+        if (!error) {
+            std::filesystem::create_directories(spill_directory, error);
+        }
+
+        // Also set on failure, so that it is tried only once; only the tail is kept then.
+        _spill_path = spill_directory / (TaskIdToFilename(_taskid) + "." + to_string(_action_index) + ".log");
+
+        if (!error) {
+            _spill_fd = open(_spill_path->c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        }
+
+        if (error) {
+            WebDash().Log(WebDashType::LogType::ERR, "Failed to create the spill directory of " + _taskid + ": " +
+                                                     error.message() + ". Keeping only the tail of its output.");
+        } else if (_spill_fd == -1) {
+            WebDash().Log(WebDashType::LogType::ERR, "Failed to open the spill file " + _spill_path->string() + ": " + strerror(errno));
+        } else {
+            const string buffered = _tail->ToString();
+            WriteAll(_spill_fd, buffered.data(), buffered.size());
+        }
+    }
+
+    if (_spill_fd != -1) {
+        WriteAll(_spill_fd, chunk.data(), chunk.size());
+    }
+
+    _tail->Write(chunk);
+}
+
+
+void WebDashOutputCapture::FinishTail(WebDashType::RunReturn& ret) {
+    if (!_tail.has_value()) {
+        return;
+    }
+
+    ret.output += _tail->ToString();
+    _tail.reset();
+
+    if (_spill_fd != -1) {
+        close(_spill_fd);
+        _spill_fd = -1;
+        ret.output_spill_files.push_back(_spill_path.value());
+    }
+}
+
+
+void WebDashOutputCapture::DrainToEnd(WebDashType::RunReturn& ret) {
+    while (ReadAvailable(ret)) {}
+}
+
+
+void WebDashOutputCapture::Replay(const std::filesystem::path& recorded, WebDashType::RunReturn& ret) {
+    CloseChildFd();
+
+    if (_read_fd != -1) close(_read_fd);
+    if (_record_fd != -1) close(_record_fd);
+    _record_fd = -1;
+
+    // A regular file cannot be spliced into another one.
+    _splice_to_log = false;
+
+    if (!_collect_to_str && !_callback && _log_fd == -1) {
+        _forward_fd = STDOUT_FILENO;
+    }
+
+    if (!_buffer) {
+        _buffer.reset(new char[kReadChunkSize]);
+    }
+
+    _read_fd = open(recorded.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (_read_fd == -1) {
+        WebDash().Log(WebDashType::LogType::ERR, "Failed to open the recorded output " + recorded.string() + ": " + strerror(errno));
+        return;
+    }
+
+    DrainToEnd(ret);
+}
+
+
+/* static */ std::filesystem::path WebDashOutputCapture::GetLogPath(const std::filesystem::path& log_directory,
+                                                                    const string& taskid) {
+    return log_directory / (TaskIdToFilename(taskid) + ".log");
+}
+
+
+/* static */ std::filesystem::path WebDashOutputCapture::GetSpillDirectory() {
+    return WebDash().GetPersistenteAppStoragePath() / "output-spill";
+}
+
+
+/* static */ void WebDashOutputCapture::ResetLog(const WebDashType::RunConfig& config, const string& taskid) {
+    if (!config.output_log_directory.has_value()) {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(config.output_log_directory.value(), error);
+
+    const int fd = open(GetLogPath(config.output_log_directory.value(), taskid).c_str(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (fd != -1) {
+        close(fd);
+    }
+}
@@ -0,0 +1,115 @@
+#include "webdash-process.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+
+using namespace std;
+
+extern char** environ;
+
+// posix_spawn_file_actions_addchdir_np() is available since glibc 2.29.
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+    #define WEBDASH_HAS_SPAWN_CHDIR 1
+#endif
+
+
+/* static */ WebDashProcessLauncher& WebDashProcessLauncher::Get(WebDashType::LauncherType type) {
+    static WebDashForkLauncher fork_launcher;
+    static WebDashPosixSpawnLauncher posix_spawn_launcher;
+
+#ifdef WEBDASH_HAS_SPAWN_CHDIR
+    if (type == WebDashType::LauncherType::PosixSpawn) {
+        return posix_spawn_launcher;
+    }
+#else
+    /* unused */ (void) type;
+    /* unused */ (void) posix_spawn_launcher;
+#endif
+
+    return fork_launcher;
+}
+
+
+pid_t WebDashForkLauncher::Launch(const vector<char*>& argv, const std::optional<string>& wdir, int output_fd) {
+    const pid_t pid = fork();
+
+    if (pid != 0) {
+        // Also set by the child; whichever runs first wins the race against a kill of the group.
+        if (pid > 0) setpgid(pid, pid);
+        return pid;
+    }
+
+    /**
+     * Child. Only async-signal-safe calls from here on: the parent might be multi-threaded.
+     */
+
+    setpgid(0, 0);
+
+    if (wdir.has_value()) {
+        if (chdir(wdir.value().c_str()) != 0) {
+            perror ("WebDashForkLauncher::Launch!chdir: Specified work directory does not exist?");
+            _exit(1);
+        }
+    }
+
+    // The child's process group is not in the foreground of the terminal; reading from it would stop the child.
+    const int null_fd = open("/dev/null", O_RDONLY);
+    if (null_fd != -1) {
+        while ((dup2(null_fd, STDIN_FILENO) == -1) && (errno == EINTR)) {}
+        if (null_fd != STDIN_FILENO) close(null_fd);
+    }
+
+    // Create copies of output_fd as the standard output and error. The original is closed on exec.
+    if (output_fd != -1) {
+        while ((dup2(output_fd, STDOUT_FILENO) == -1) && (errno == EINTR)) {}
+        while ((dup2(output_fd, STDERR_FILENO) == -1) && (errno == EINTR)) {}
+    }
+
+    execvp(argv[0], argv.data());
+    perror ("WebDashForkLauncher::Launch!execvp");
+
+    _exit(1);
+}
+
+
+pid_t WebDashPosixSpawnLauncher::Launch(const vector<char*>& argv, const std::optional<string>& wdir, int output_fd) {
+#ifdef WEBDASH_HAS_SPAWN_CHDIR
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+
+    if (wdir.has_value()) {
+        posix_spawn_file_actions_addchdir_np(&file_actions, wdir.value().c_str());
+    }
+
+    posix_spawn_file_actions_addopen(&file_actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+
+    if (output_fd != -1) {
+        posix_spawn_file_actions_adddup2(&file_actions, output_fd, STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&file_actions, output_fd, STDERR_FILENO);
+    }
+
+    // The child leads a new process group (see WebDashProcessLauncher::Launch).
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attributes, 0);
+
+    pid_t pid = -1;
+    const int error = posix_spawnp(&pid, argv[0], &file_actions, &attributes, argv.data(), environ);
+
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&file_actions);
+
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+
+    return pid;
+#else
+    return WebDashForkLauncher().Launch(argv, wdir, output_fd);
+#endif
+}
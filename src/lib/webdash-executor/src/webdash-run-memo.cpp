@@ -0,0 +1,56 @@
+#include "webdash-run-memo.hpp"
+#include "webdash-core.hpp"
+
+using namespace std;
+
+
+std::optional<WebDashType::RunReturn> WebDashRunMemo::Claim(const string& taskid) {
+    unique_lock<mutex> lock(_mutex);
+
+    auto it = _entries.find(taskid);
+
+    if (it == _entries.end()) {
+        _entries[taskid].owner = this_thread::get_id();
+        return nullopt;
+    }
+
+    if (!it->second.finished && it->second.owner == this_thread::get_id()) {
+        lock.unlock();
+        WebDash().Log(WebDashType::LogType::ERR, "Task reached through itself (cycle): " + taskid);
+
+        WebDashType::RunReturn cycle;
+        cycle.return_code = 1;
+        return cycle;
+    }
+
+    // References into unordered_map stay valid on rehashing.
+    Entry& entry = it->second;
+    _completed.wait(lock, [&entry]() { return entry.finished; });
+
+    // The output was already delivered (and the resources accounted for) by the first execution.
+    WebDashType::RunReturn reused = entry.result;
+    reused.output.clear();
+    reused.resource_usage = {};
+    reused.action_resource_usage.clear();
+
+    return reused;
+}
+
+
+void WebDashRunMemo::Complete(const string& taskid, const WebDashType::RunReturn& result) {
+    {
+        lock_guard<mutex> lock(_mutex);
+
+        Entry& entry = _entries[taskid];
+        entry.result = result;
+        entry.finished = true;
+    }
+
+    _completed.notify_all();
+}
+
+
+bool WebDashRunMemo::Contains(const string& taskid) {
+    lock_guard<mutex> lock(_mutex);
+    return _entries.count(taskid) > 0;
+}
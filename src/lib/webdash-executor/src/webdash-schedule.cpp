@@ -0,0 +1,414 @@
+#include "webdash-schedule.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+
+namespace {
+
+    // A missed calendar time older than this is caught up as if it was the oldest one in the window. Long enough
+    // for a time that exists in leap years only.
+    constexpr std::chrono::hours kCatchUpWindow{ 24 * 366 * 8 };
+
+    // Bounds the search for schedules that never fire.
+    constexpr int kMaxSearchSteps = 100000;
+
+    constexpr const char* kMonthNames[] = { "jan", "feb", "mar", "apr", "may", "jun",
+                                            "jul", "aug", "sep", "oct", "nov", "dec" };
+
+    constexpr const char* kWeekdayNames[] = { "sun", "mon", "tue", "wed", "thu", "fri", "sat" };
+
+
+    bool is_number(const std::string& s) {
+        char* end = 0;
+        const double val = strtod(s.c_str(), &end);
+        return end != s.c_str() && *end == '\0' && val != HUGE_VAL;
+    }
+
+
+    string ToLower(string text) {
+        for (auto& c : text) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        return text;
+    }
+
+
+    vector<string> Split(const string& text, char separator) {
+        vector<string> parts;
+        std::istringstream iss(text);
+
+        for (string part; getline(iss, part, separator);) {
+            parts.push_back(part);
+        }
+
+        return parts;
+    }
+
+
+    /**
+     * @returns The value of a decimal number or (for names != nullptr) a name, offset by first_value.
+     */
+    std::optional<int> ParseFieldValue(const string& text, const char* const* names, int name_count, int first_value) {
+        if (!text.empty() && all_of(text.begin(), text.end(), [](unsigned char c) { return isdigit(c); })) {
+            return text.size() <= 4 ? std::optional<int>(stoi(text)) : nullopt;
+        }
+
+        for (int i = 0; names && i < name_count; ++i) {
+            if (text == names[i]) {
+                return first_value + i;
+            }
+        }
+
+        return nullopt;
+    }
+
+
+    /**
+     * @brief Parses a cron field: a comma-separated list of `*`, values or ranges (`a-b`), each with an optional
+     *        step (`/n`).
+     * @returns The bit mask of the matching values in [min_value, max_value]; nullopt if malformed.
+     */
+    std::optional<uint64_t> ParseField(const string& field, int min_value, int max_value,
+                                       const char* const* names = nullptr, int name_count = 0) {
+        uint64_t mask = 0;
+
+        for (const auto& item : Split(field, ',')) {
+            const auto slash = item.find('/');
+            const string range = item.substr(0, slash);
+
+            int step = 1;
+            if (slash != string::npos) {
+                const auto parsed_step = ParseFieldValue(item.substr(slash + 1), nullptr, 0, 0);
+                if (!parsed_step.has_value() || parsed_step.value() == 0) return nullopt;
+                step = parsed_step.value();
+            }
+
+            int first = min_value;
+            int last = max_value;
+
+            if (range != "*") {
+                const auto dash = range.find('-');
+                const auto parsed_first = ParseFieldValue(range.substr(0, dash), names, name_count, min_value);
+                if (!parsed_first.has_value()) return nullopt;
+
+                first = parsed_first.value();
+
+                if (dash != string::npos) {
+                    const auto parsed_last = ParseFieldValue(range.substr(dash + 1), names, name_count, min_value);
+                    if (!parsed_last.has_value()) return nullopt;
+                    last = parsed_last.value();
+                } else if (slash == string::npos) {
+                    last = first;
+                }
+            }
+
+            if (first < min_value || last > max_value || first > last) {
+                return nullopt;
+            }
+
+            for (int value = first; value <= last; value += step) {
+                mask |= uint64_t(1) << value;
+            }
+        }
+
+        return mask != 0 ? std::optional<uint64_t>(mask) : nullopt;
+    }
+
+
+    /**
+     * @returns The smallest set bit >= from; -1 if there is none.
+     */
+    int NextBit(uint64_t mask, int from) {
+        const uint64_t remaining = from < 64 ? mask >> from : 0;
+        return remaining ? from + std::countr_zero(remaining) : -1;
+    }
+
+
+    /**
+     * @brief Lets mktime carry over fields that are out of range (e.g., the 32nd day), then recomputes the weekday.
+     */
+    void Normalize(std::tm& local) {
+        local.tm_isdst = -1;
+        const std::time_t time = mktime(&local);
+        localtime_r(&time, &local);
+    }
+
+} // namespace
+
+
+/* static */ std::optional<WebDashSchedule> WebDashSchedule::Parse(const string& raw_expression) {
+    const string expression = ToLower(raw_expression);
+
+    if (expression == "new-day" || expression == "@daily" || expression == "@midnight") {
+        return ParseCron("0 0 * * *");
+    }
+
+    if (expression == "@hourly") return ParseCron("0 * * * *");
+    if (expression == "@weekly") return ParseCron("0 0 * * 0");
+    if (expression == "@monthly") return ParseCron("0 0 1 * *");
+    if (expression == "@yearly" || expression == "@annually") return ParseCron("0 0 1 1 *");
+
+    std::istringstream iss(expression);
+    const vector<string> tokens{ std::istream_iterator<string>{ iss }, std::istream_iterator<string>() };
+
+    if (tokens.size() == 5) {
+        return ParseCron(expression);
+    }
+
+    /**
+     * A time of day ("HH:MM"), optionally preceded by the days it applies to.
+     */
+
+    if ((tokens.size() == 1 || tokens.size() == 2) && tokens.back().find(':') != string::npos) {
+        const auto time_parts = Split(tokens.back(), ':');
+
+        if (time_parts.size() != 2 || time_parts[0].empty() || time_parts[1].size() != 2) {
+            return nullopt;
+        }
+
+        string weekdays = "*";
+
+        if (tokens.size() == 2) {
+            if (tokens[0] == "weekdays") {
+                weekdays = "1-5";
+            } else if (tokens[0] == "weekends") {
+                weekdays = "0,6";
+            } else if (tokens[0] != "daily") {
+                weekdays = tokens[0];
+            }
+        }
+
+        return ParseCron(time_parts[1] + " " + time_parts[0] + " * * " + weekdays);
+    }
+
+    if (tokens.size() == 1) {
+        return ParseInterval(expression);
+    }
+
+    return nullopt;
+}
+
+
+/* static */ std::optional<WebDashSchedule> WebDashSchedule::ParseInterval(const string& expression) {
+    WebDashSchedule schedule;
+
+    if (expression == "hourly") {
+        schedule._interval = std::chrono::hours(1);
+        return schedule;
+    }
+
+    if (expression == "daily") {
+        schedule._interval = std::chrono::hours(24);
+        return schedule;
+    }
+
+    const auto interval = ParseDuration(expression);
+
+    if (!interval.has_value()) {
+        return nullopt;
+    }
+
+    schedule._interval = interval;
+    return schedule;
+}
+
+
+/* static */ std::optional<std::chrono::milliseconds> WebDashSchedule::ParseDuration(const string& raw_expression) {
+    const string expression = ToLower(raw_expression);
+
+    // Plain numbers are milliseconds.
+    if (is_number(expression)) {
+        return std::chrono::milliseconds(static_cast<long long>(stod(expression)));
+    }
+
+    if (expression.empty()) {
+        return nullopt;
+    }
+
+    // Otherwise, a sequence of <number><unit>.
+    std::chrono::milliseconds duration{ 0 };
+    size_t position = 0;
+
+    while (position < expression.size()) {
+        const size_t number_begin = position;
+        while (position < expression.size() && isdigit(static_cast<unsigned char>(expression[position]))) position++;
+
+        const size_t unit_begin = position;
+        while (position < expression.size() && isalpha(static_cast<unsigned char>(expression[position]))) position++;
+
+        if (number_begin == unit_begin || unit_begin == position || unit_begin - number_begin > 9) {
+            return nullopt;
+        }
+
+        const long long count = stoll(expression.substr(number_begin, unit_begin - number_begin));
+        const string unit = expression.substr(unit_begin, position - unit_begin);
+
+        if (unit == "ms") {
+            duration += std::chrono::milliseconds(count);
+        } else if (unit == "s") {
+            duration += std::chrono::seconds(count);
+        } else if (unit == "m") {
+            duration += std::chrono::minutes(count);
+        } else if (unit == "h") {
+            duration += std::chrono::hours(count);
+        } else if (unit == "d") {
+            duration += std::chrono::hours(24 * count);
+        } else {
+            return nullopt;
+        }
+    }
+
+    return duration;
+}
+
+
+/* static */ std::optional<WebDashSchedule> WebDashSchedule::ParseCron(const string& expression) {
+    std::istringstream iss(expression);
+    const vector<string> fields{ std::istream_iterator<string>{ iss }, std::istream_iterator<string>() };
+
+    if (fields.size() != 5) {
+        return nullopt;
+    }
+
+    const auto minutes = ParseField(fields[0], 0, 59);
+    const auto hours = ParseField(fields[1], 0, 23);
+    const auto days_of_month = ParseField(fields[2], 1, 31);
+    const auto months = ParseField(fields[3], 1, 12, kMonthNames, 12);
+    const auto weekdays = ParseField(fields[4], 0, 7, kWeekdayNames, 7);
+
+    if (!minutes || !hours || !days_of_month || !months || !weekdays) {
+        return nullopt;
+    }
+
+    WebDashSchedule schedule;
+    schedule._minutes = minutes.value();
+    schedule._hours = static_cast<uint32_t>(hours.value());
+    schedule._days_of_month = static_cast<uint32_t>(days_of_month.value());
+    schedule._months = static_cast<uint16_t>(months.value());
+
+    // Both 0 and 7 are Sunday.
+    schedule._weekdays = static_cast<uint8_t>((weekdays.value() | (weekdays.value() >> 7)) & 0x7f);
+
+    schedule._day_of_month_starts_with_star = fields[2][0] == '*';
+    schedule._weekday_starts_with_star = fields[4][0] == '*';
+
+    return schedule;
+}
+
+
+bool WebDashSchedule::MatchesDay(int day_of_month, int weekday) const {
+    const bool day_of_month_matches = (_days_of_month >> day_of_month) & 1;
+    const bool weekday_matches = (_weekdays >> weekday) & 1;
+
+    // A field that is `*` matches every day; one like `*/2` still restricts the days.
+    if (_day_of_month_starts_with_star || _weekday_starts_with_star) {
+        return day_of_month_matches && weekday_matches;
+    }
+
+    return day_of_month_matches || weekday_matches;
+}
+
+
+std::optional<std::chrono::system_clock::time_point> WebDashSchedule::NextAfter(std::chrono::system_clock::time_point last_execution,
+                                                                                std::chrono::milliseconds offset) const {
+    // A zero interval ("0") has no phase.
+    if (offset.count() == 0 || (_interval.has_value() && _interval->count() <= 0)) {
+        return NextAfter(last_execution);
+    }
+
+    if (!_interval.has_value()) {
+        auto next_time = NextAfter(last_execution);
+        if (next_time.has_value()) next_time.value() += offset;
+        return next_time;
+    }
+
+    const int64_t interval = _interval->count();
+    const int64_t since_phase =
+        std::chrono::duration_cast<std::chrono::milliseconds>(last_execution.time_since_epoch()).count() - offset.count();
+
+    // Rounded down, also before the epoch.
+    int64_t periods = since_phase / interval;
+    if (since_phase % interval < 0) periods--;
+
+    return std::chrono::system_clock::time_point(std::chrono::milliseconds(offset.count() + (periods + 1) * interval));
+}
+
+
+std::optional<std::chrono::system_clock::time_point> WebDashSchedule::NextAfter(std::chrono::system_clock::time_point last_execution) const {
+    if (_interval.has_value()) {
+        return last_execution + _interval.value();
+    }
+
+    // Tasks that never ran (or not for years) are due at the first calendar time within the window.
+    last_execution = max(last_execution, std::chrono::system_clock::now() - kCatchUpWindow);
+
+    // The first whole minute after the last execution.
+    std::time_t start = std::chrono::system_clock::to_time_t(last_execution);
+    start = start - start % 60 + 60;
+
+    std::tm local;
+    localtime_r(&start, &local);
+
+    /**
+     * Skips whole months, days and hours that do not match, so the number of steps does not depend on the distance
+     * to the next execution in minutes.
+     */
+
+    for (int step = 0; step < kMaxSearchSteps; ++step) {
+        if (!((_months >> (local.tm_mon + 1)) & 1)) {
+            local.tm_mon++;
+            local.tm_mday = 1;
+            local.tm_hour = 0;
+            local.tm_min = 0;
+            Normalize(local);
+            continue;
+        }
+
+        if (!MatchesDay(local.tm_mday, local.tm_wday)) {
+            local.tm_mday++;
+            local.tm_hour = 0;
+            local.tm_min = 0;
+            Normalize(local);
+            continue;
+        }
+
+        const int hour = NextBit(_hours, local.tm_hour);
+
+        if (hour < 0) {
+            local.tm_mday++;
+            local.tm_hour = 0;
+            local.tm_min = 0;
+            Normalize(local);
+            continue;
+        }
+
+        if (hour != local.tm_hour) {
+            local.tm_hour = hour;
+            local.tm_min = 0;
+        }
+
+        const int minute = NextBit(_minutes, local.tm_min);
+
+        if (minute < 0) {
+            local.tm_hour++;
+            local.tm_min = 0;
+            Normalize(local);
+            continue;
+        }
+
+        local.tm_min = minute;
+        local.tm_sec = 0;
+        local.tm_isdst = -1;
+
+        return std::chrono::system_clock::from_time_t(mktime(&local));
+    }
+
+    return nullopt;
+}
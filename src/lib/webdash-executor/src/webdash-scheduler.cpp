@@ -0,0 +1,252 @@
+#include "webdash-scheduler.hpp"
+#include "webdash-core.hpp"
+
+#include <stdexcept>
+
+using namespace std;
+
+
+WebDashScheduler::WebDashScheduler(TaskRunner runner, size_t max_concurrent_tasks)
+    : _runner(std::move(runner)), _max_concurrent_tasks(max(max_concurrent_tasks, size_t(1))) {}
+
+
+WebDashScheduler::~WebDashScheduler() {
+    Stop();
+}
+
+
+namespace {
+
+    // The tasks keep their execution time on the system clock; waiting happens on the steady clock.
+    std::chrono::steady_clock::time_point ToSteadyClock(std::chrono::high_resolution_clock::time_point time) {
+        const auto until_time = time - std::chrono::high_resolution_clock::now();
+        return std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(until_time);
+    }
+
+} // namespace
+
+
+void WebDashScheduler::Schedule(const string& taskid, const Entry& entry, std::chrono::steady_clock::time_point not_before) {
+    _due.push({ max(ToSteadyClock(entry.task.GetNextDueTime().value()), not_before), taskid, entry.generation });
+}
+
+
+bool WebDashScheduler::Add(WebDashConfigTask task) {
+    if (!task.GetNextDueTime().has_value()) {
+        return false;
+    }
+
+    {
+        lock_guard<mutex> lock(_mutex);
+
+        const string taskid = task.GetTaskId();
+
+        // A previous version that is running right now is not rescheduled afterwards (see Execute).
+        auto [it, inserted] = _entries.insert_or_assign(taskid, Entry{ std::move(task), _next_generation++ });
+        Schedule(taskid, it->second, std::chrono::steady_clock::time_point::min());
+    }
+
+    _wakeup.notify_all();
+    return true;
+}
+
+
+size_t WebDashScheduler::RemoveConfig(const string& config_path) {
+    lock_guard<mutex> lock(_mutex);
+
+    // Task ids are `<config path>#<name>`.
+    auto BelongsToConfig = [&config_path](const string& taskid) {
+        return taskid.size() > config_path.size() && taskid.compare(0, config_path.size(), config_path) == 0 &&
+               taskid[config_path.size()] == '#';
+    };
+
+    size_t removed_count = 0;
+
+    // Tasks running right now finish, but are not rescheduled (see Execute).
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        if (BelongsToConfig(it->first)) {
+            it = _entries.erase(it);
+            removed_count++;
+        } else {
+            ++it;
+        }
+    }
+
+    return removed_count;
+}
+
+
+std::optional<pair<string, WebDashScheduler::Entry>> WebDashScheduler::TakeDue(std::chrono::steady_clock::time_point now) {
+    while (true) {
+        DropStale();
+
+        if (_due.empty() || _due.top().due_time > now) {
+            return nullopt;
+        }
+
+        // Current after DropStale.
+        const string taskid = _due.top().taskid;
+        _due.pop();
+
+        // A replacement of a task that is still running waits for it; Execute schedules the replacement afterwards.
+        if (!_running.insert(taskid).second) {
+            continue;
+        }
+
+        Entry& entry = _entries.find(taskid)->second;
+        return pair<string, Entry>{ taskid, Entry{ entry.task, entry.generation } };
+    }
+}
+
+
+void WebDashScheduler::Execute(const string& taskid, Entry entry) {
+    const auto previous_due_time = entry.task.GetNextDueTime();
+
+    try {
+        _runner(entry.task);
+    } catch (const std::exception& e) {
+        WebDash().Log(WebDashType::LogType::ERR, "Scheduled execution of " + taskid + " failed: " + e.what());
+    }
+
+    // Without a new execution time, the task would be due again right away.
+    auto not_before = entry.task.GetNextDueTime() == previous_due_time
+                                ? std::chrono::steady_clock::now() + kMinimumRescheduleDelay
+                                : std::chrono::steady_clock::time_point::min();
+
+    {
+        lock_guard<mutex> lock(_mutex);
+
+        _running.erase(taskid);
+
+        auto current = _entries.find(taskid);
+
+        // Removed while running.
+        if (current == _entries.end()) {
+            return;
+        }
+
+        if (current->second.generation == entry.generation) {
+            current->second.task = std::move(entry.task);
+        } else {
+            // Replaced while running. The replacement is not due before the task would have been due again, and its
+            // heap entry (if still there) might be earlier.
+            const auto next_due_time = entry.task.GetNextDueTime();
+            if (next_due_time.has_value()) {
+                not_before = max(not_before, ToSteadyClock(next_due_time.value()));
+            }
+
+            current->second.generation = _next_generation++;
+        }
+
+        Schedule(taskid, current->second, not_before);
+    }
+
+    _wakeup.notify_all();
+}
+
+
+std::optional<std::chrono::steady_clock::time_point> WebDashScheduler::RunDue(std::chrono::steady_clock::time_point now) {
+    vector<pair<string, Entry>> due_entries;
+
+    {
+        lock_guard<mutex> lock(_mutex);
+
+        while (auto due = TakeDue(now)) {
+            due_entries.push_back(std::move(due.value()));
+        }
+    }
+
+    for (auto& [taskid, entry] : due_entries) {
+        Execute(taskid, std::move(entry));
+    }
+
+    lock_guard<mutex> lock(_mutex);
+    DropStale();
+
+    if (_due.empty()) {
+        return nullopt;
+    }
+
+    return _due.top().due_time;
+}
+
+
+void WebDashScheduler::DropStale() {
+    while (!_due.empty()) {
+        auto entry = _entries.find(_due.top().taskid);
+
+        if (entry != _entries.end() && entry->second.generation == _due.top().generation) {
+            return;
+        }
+
+        _due.pop();
+    }
+}
+
+
+size_t WebDashScheduler::Size() {
+    lock_guard<mutex> lock(_mutex);
+    return _entries.size();
+}
+
+
+void WebDashScheduler::Start() {
+    lock_guard<mutex> lock(_mutex);
+
+    if (!_threads.empty()) {
+        return;
+    }
+
+    _stopping = false;
+
+    for (size_t i = 0; i < _max_concurrent_tasks; ++i) {
+        _threads.emplace_back([this]() { Loop(); });
+    }
+}
+
+
+void WebDashScheduler::Stop() {
+    {
+        lock_guard<mutex> lock(_mutex);
+        _stopping = true;
+    }
+
+    _wakeup.notify_all();
+
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+
+    _threads.clear();
+}
+
+
+void WebDashScheduler::Loop() {
+    unique_lock<mutex> lock(_mutex);
+
+    while (!_stopping) {
+        DropStale();
+
+        if (_due.empty()) {
+            _wakeup.wait(lock);
+            continue;
+        }
+
+        const auto due_time = _due.top().due_time;
+
+        if (std::chrono::steady_clock::now() < due_time) {
+            _wakeup.wait_until(lock, due_time);
+            continue;
+        }
+
+        auto due = TakeDue(std::chrono::steady_clock::now());
+
+        if (!due.has_value()) {
+            continue;
+        }
+
+        lock.unlock();
+        Execute(due->first, std::move(due->second));
+        lock.lock();
+    }
+}
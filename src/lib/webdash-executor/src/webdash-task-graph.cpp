@@ -0,0 +1,237 @@
+#include "webdash-task-graph.hpp"
+#include "webdash-core.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+
+WebDashTaskGraph::TaskHandle WebDashTaskGraph::Intern(std::optional<WebDashConfigTask> owned_task,
+                                                      WebDashConfigTask* task) {
+    const string& taskid = owned_task.has_value() ? owned_task->GetTaskId() : task->GetTaskId();
+
+    auto existing = _handle_by_taskid.find(taskid);
+    if (existing != _handle_by_taskid.end()) {
+        return existing->second;
+    }
+
+    if (owned_task.has_value()) {
+        _owned_tasks.push_back(std::move(owned_task.value()));
+        task = &_owned_tasks.back();
+    }
+
+    const TaskHandle handle = static_cast<TaskHandle>(_tasks.size());
+    _tasks.push_back(task);
+    _handle_by_taskid[task->GetTaskId()] = handle;
+
+    return handle;
+}
+
+
+WebDashTaskGraph::TaskHandle WebDashTaskGraph::Resolve(const string& reference, const WebDashType::RunConfig& config) {
+    auto known = _handle_by_reference.find(reference);
+    if (known != _handle_by_reference.end()) {
+        return known->second;
+    }
+
+    auto task = config.TaskRetriever(reference);
+    const TaskHandle handle = task.has_value() ? Intern(std::move(task), nullptr) : kNoTask;
+
+    _handle_by_reference[reference] = handle;
+    return handle;
+}
+
+
+void WebDashTaskGraph::Link(const vector<WebDashConfigTask*>& targets, const WebDashType::RunConfig& config,
+                            const ExpandPredicate& expand) {
+
+    /**
+     * First, the targets and their transitive dependencies. Handles are processed in the order they are created, so
+     * the rows of the dependency array are appended in handle order.
+     */
+
+    for (WebDashConfigTask* target : targets) {
+        _targets.push_back(Intern(nullopt, target));
+    }
+
+    vector<bool> expanded;
+    _dependency_offsets.push_back(0);
+
+    for (TaskHandle handle = 0; handle < _tasks.size(); ++handle) {
+        expanded.push_back(expand(handle, *_tasks[handle]));
+
+        if (expanded.back()) {
+            // Copied, as resolving may grow _owned_tasks.
+            const vector<string> dependencies = _tasks[handle]->GetDependencies();
+
+            for (const auto& dependency : dependencies) {
+                const TaskHandle dependency_handle = Resolve(dependency, config);
+
+                if (dependency_handle == kNoTask) {
+                    WebDash().Log(WebDashType::LogType::WARN, "Dependency of " + _tasks[handle]->GetTaskId() + " not found: " + dependency);
+                    continue;
+                }
+
+                auto row_begin = _dependency_edges.begin() + _dependency_offsets.back();
+                if (find(row_begin, _dependency_edges.end(), dependency_handle) == _dependency_edges.end()) {
+                    _dependency_edges.push_back(dependency_handle);
+                }
+            }
+        }
+
+        _dependency_offsets.push_back(static_cast<uint32_t>(_dependency_edges.size()));
+    }
+
+    _scheduled_count = _tasks.size();
+
+    /**
+     * Then, the sub-task actions of the expanded tasks. The tasks they reach run in place, together with their own
+     * dependencies and sub-tasks, so those are linked as well.
+     */
+
+    _subtask_offsets.push_back(0);
+
+    for (TaskHandle handle = 0; handle < _tasks.size(); ++handle) {
+        const bool is_scheduled = handle < _scheduled_count;
+
+        if (!is_scheduled) {
+            const vector<string> dependencies = _tasks[handle]->GetDependencies();
+            const size_t row_begin = _dependency_edges.size();
+
+            for (const auto& dependency : dependencies) {
+                const TaskHandle dependency_handle = Resolve(dependency, config);
+
+                if (dependency_handle == kNoTask) {
+                    WebDash().Log(WebDashType::LogType::WARN, "Dependency of " + _tasks[handle]->GetTaskId() + " not found: " + dependency);
+                    continue;
+                }
+
+                if (find(_dependency_edges.begin() + row_begin, _dependency_edges.end(), dependency_handle) == _dependency_edges.end()) {
+                    _dependency_edges.push_back(dependency_handle);
+                }
+            }
+
+            _dependency_offsets.push_back(static_cast<uint32_t>(_dependency_edges.size()));
+        }
+
+        const vector<WebDashType::CompiledAction> actions = _tasks[handle]->GetCompiledActions();
+
+        for (const auto& action : actions) {
+            const bool follow = action.kind == WebDashType::CompiledAction::Kind::SubTask &&
+                                (!is_scheduled || expanded[handle]);
+
+            _subtask_edges.push_back(follow ? Resolve(action.reference, config) : kNoTask);
+        }
+
+        _subtask_offsets.push_back(static_cast<uint32_t>(_subtask_edges.size()));
+    }
+
+    /**
+     * Finally, the reverse of the dependency rows of the scheduled tasks.
+     */
+
+    _dependent_offsets.assign(_tasks.size() + 1, 0);
+
+    for (size_t i = 0; i < _dependency_offsets[_scheduled_count]; ++i) {
+        _dependent_offsets[_dependency_edges[i] + 1]++;
+    }
+
+    for (size_t i = 1; i < _dependent_offsets.size(); ++i) {
+        _dependent_offsets[i] += _dependent_offsets[i - 1];
+    }
+
+    _dependent_edges.resize(_dependency_offsets[_scheduled_count]);
+    vector<uint32_t> fill_position(_dependent_offsets.begin(), _dependent_offsets.end() - 1);
+
+    for (TaskHandle handle = 0; handle < _scheduled_count; ++handle) {
+        for (TaskHandle dependency : Dependencies(handle)) {
+            _dependent_edges[fill_position[dependency]++] = handle;
+        }
+    }
+}
+
+
+std::span<const WebDashTaskGraph::TaskHandle> WebDashTaskGraph::Dependencies(TaskHandle handle) const {
+    return { _dependency_edges.data() + _dependency_offsets[handle], _dependency_offsets[handle + 1] - _dependency_offsets[handle] };
+}
+
+
+std::span<const WebDashTaskGraph::TaskHandle> WebDashTaskGraph::Dependents(TaskHandle handle) const {
+    return { _dependent_edges.data() + _dependent_offsets[handle], _dependent_offsets[handle + 1] - _dependent_offsets[handle] };
+}
+
+
+std::span<const WebDashTaskGraph::TaskHandle> WebDashTaskGraph::SubTasks(TaskHandle handle) const {
+    return { _subtask_edges.data() + _subtask_offsets[handle], _subtask_offsets[handle + 1] - _subtask_offsets[handle] };
+}
+
+
+WebDashTaskGraph::TaskHandle WebDashTaskGraph::Find(const string& reference) const {
+    auto known = _handle_by_reference.find(reference);
+    return known != _handle_by_reference.end() ? known->second : kNoTask;
+}
+
+
+std::optional<vector<WebDashTaskGraph::TaskHandle>> WebDashTaskGraph::FindCycle() const {
+    enum class Visit : uint8_t { None, Active, Done };
+    vector<Visit> visits(_tasks.size(), Visit::None);
+
+    // Depth-first, without recursion: each entry is a task on the current path and the index of its next edge, where
+    // the dependencies come before the sub-tasks.
+    vector<pair<TaskHandle, size_t>> path;
+
+    for (TaskHandle root = 0; root < _tasks.size(); ++root) {
+        if (visits[root] != Visit::None) continue;
+
+        visits[root] = Visit::Active;
+        path.push_back({ root, 0 });
+
+        while (!path.empty()) {
+            const TaskHandle handle = path.back().first;
+            const size_t edge_index = path.back().second++;
+
+            const auto dependencies = Dependencies(handle);
+            const auto subtasks = SubTasks(handle);
+
+            if (edge_index >= dependencies.size() + subtasks.size()) {
+                visits[handle] = Visit::Done;
+                path.pop_back();
+                continue;
+            }
+
+            const TaskHandle next = edge_index < dependencies.size() ? dependencies[edge_index]
+                                                                     : subtasks[edge_index - dependencies.size()];
+
+            if (next == kNoTask || visits[next] == Visit::Done) continue;
+
+            if (visits[next] == Visit::Active) {
+                vector<TaskHandle> cycle;
+                auto cycle_begin = find_if(path.begin(), path.end(), [next](const auto& entry) { return entry.first == next; });
+
+                for (auto it = cycle_begin; it != path.end(); ++it) {
+                    cycle.push_back(it->first);
+                }
+
+                cycle.push_back(next);
+                return cycle;
+            }
+
+            visits[next] = Visit::Active;
+            path.push_back({ next, 0 });
+        }
+    }
+
+    return nullopt;
+}
+
+
+string WebDashTaskGraph::FormatPath(const vector<TaskHandle>& path) const {
+    string formatted;
+
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (i) formatted += " -> ";
+        formatted += _tasks[path[i]]->GetTaskId();
+    }
+
+    return formatted;
+}
@@ -0,0 +1,231 @@
+#include "webdash-timing-history.hpp"
+#include "webdash-core.hpp"
+#include "webdash-utils.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+namespace {
+
+    /**
+     * @returns The value at the given percentile of the sorted values (nearest rank).
+     */
+    int64_t Percentile(const vector<int64_t>& sorted_values, double percentile) {
+        if (sorted_values.empty()) {
+            return 0;
+        }
+
+        const size_t rank = static_cast<size_t>(percentile / 100.0 * (sorted_values.size() - 1) + 0.5);
+        return sorted_values[min(rank, sorted_values.size() - 1)];
+    }
+
+    int64_t Median(vector<int64_t> values) {
+        sort(values.begin(), values.end());
+        return Percentile(values, 50);
+    }
+
+    int64_t ToMicroseconds(std::chrono::nanoseconds duration) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    }
+
+} // namespace
+
+
+/* static */ WebDashTimingHistory& WebDashTimingHistory::Get() {
+    static WebDashTimingHistory history;
+    return history;
+}
+
+
+/* static */ std::filesystem::path WebDashTimingHistory::GetHistoryPath() {
+    return WebDash().GetPersistenteAppStoragePath() / kHistoryFilename;
+}
+
+
+void WebDashTimingHistory::Append(const string& taskid,
+                                  std::chrono::system_clock::time_point start_time,
+                                  std::chrono::microseconds duration,
+                                  const WebDashType::RunReturn& result) {
+    Record record = {};
+    record.taskid_hash = WebDashUtils::HashFnv1a(taskid);
+    record.start_unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(start_time.time_since_epoch()).count();
+    record.duration_us = duration.count();
+    record.return_code = result.return_code;
+    record.flags = (result.timed_out ? Record::kTimedOut : 0) | (result.cancelled ? Record::kCancelled : 0);
+
+    const auto& usage = result.resource_usage;
+    record.user_cpu_us = ToMicroseconds(usage.user_cpu_time);
+    record.system_cpu_us = ToMicroseconds(usage.system_cpu_time);
+    record.max_rss_kb = usage.max_rss_kb;
+    record.block_input_operations = usage.block_input_operations;
+    record.block_output_operations = usage.block_output_operations;
+    record.voluntary_context_switches = usage.voluntary_context_switches;
+    record.involuntary_context_switches = usage.involuntary_context_switches;
+
+    lock_guard<mutex> lock(_mutex);
+
+    if (_estimates_loaded) {
+        AddToEstimate(record);
+    }
+
+    const auto path = GetHistoryPath();
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+    if (fd == -1) {
+        WebDash().Log(WebDashType::LogType::ERR, "Failed to open the timing history " + path.string() + ": " + strerror(errno));
+        return;
+    }
+
+    // Other webdash processes might create the header or append at the same time.
+    flock(fd, LOCK_EX);
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size == 0) {
+        Header header = {};
+        memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.record_size = sizeof(Record);
+
+        /* unused */ (void) !write(fd, &header, sizeof(header));
+    }
+
+    if (write(fd, &record, sizeof(record)) != static_cast<ssize_t>(sizeof(record))) {
+        WebDash().Log(WebDashType::LogType::ERR, "Failed to append to the timing history: " + string(strerror(errno)));
+    }
+
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+
+vector<WebDashTimingHistory::Record> WebDashTimingHistory::Read(const string& taskid) const {
+    vector<Record> records;
+    const uint64_t taskid_hash = WebDashUtils::HashFnv1a(taskid);
+
+    ForEachRecord([&](const Record& record) {
+        if (record.taskid_hash == taskid_hash) {
+            records.push_back(record);
+        }
+    });
+
+    return records;
+}
+
+
+std::optional<std::chrono::milliseconds> WebDashTimingHistory::EstimateDuration(const string& taskid) {
+    lock_guard<mutex> lock(_mutex);
+
+    if (!_estimates_loaded) {
+        _estimates_loaded = true;
+        ForEachRecord([this](const Record& record) { AddToEstimate(record); });
+    }
+
+    auto estimate = _estimated_duration_us_by_taskid_hash.find(WebDashUtils::HashFnv1a(taskid));
+    if (estimate == _estimated_duration_us_by_taskid_hash.end()) {
+        return nullopt;
+    }
+
+    return std::chrono::milliseconds(static_cast<long long>(estimate->second / 1000));
+}
+
+
+void WebDashTimingHistory::AddToEstimate(const Record& record) {
+    // Failed runs (including timed out and cancelled ones) often end early; they say little about the usual duration.
+    if (record.return_code != 0) {
+        return;
+    }
+
+    const double latest_us = static_cast<double>(record.duration_us);
+    auto [estimate, is_new] = _estimated_duration_us_by_taskid_hash.try_emplace(record.taskid_hash, latest_us);
+
+    if (!is_new) {
+        estimate->second = kLatestRunWeight * latest_us + (1 - kLatestRunWeight) * estimate->second;
+    }
+}
+
+
+/* static */ void WebDashTimingHistory::ForEachRecord(const std::function<void(const Record&)>& visit) {
+    const auto path = GetHistoryPath();
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1) {
+        return;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(Header))) {
+        close(fd);
+        return;
+    }
+
+    const size_t size = file_stat.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        WebDash().Log(WebDashType::LogType::ERR, "Failed to map the timing history: " + string(strerror(errno)));
+        return;
+    }
+
+    const char* data = static_cast<const char*>(mapping);
+
+    Header header;
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.record_size != sizeof(Record)) {
+        WebDash().Log(WebDashType::LogType::ERR, "Unknown format of the timing history: " + path.string());
+        munmap(mapping, size);
+        return;
+    }
+
+    const size_t record_count = (size - sizeof(Header)) / sizeof(Record);
+
+    for (size_t i = 0; i < record_count; ++i) {
+        Record record;
+        memcpy(&record, data + sizeof(Header) + i * sizeof(Record), sizeof(Record));
+        visit(record);
+    }
+
+    munmap(mapping, size);
+}
+
+
+/* static */ WebDashTimingHistory::Statistics WebDashTimingHistory::ComputeStatistics(const vector<Record>& records) {
+    Statistics statistics;
+    statistics.run_count = records.size();
+
+    vector<int64_t> durations;
+
+    for (const auto& record : records) {
+        durations.push_back(record.duration_us);
+        statistics.failure_count += record.return_code != 0;
+        statistics.max_rss_kb = max(statistics.max_rss_kb, record.max_rss_kb);
+    }
+
+    if (records.size() >= 2 * kTrendWindow) {
+        const auto latest_begin = durations.end() - kTrendWindow;
+        const int64_t previous_median = Median(vector<int64_t>(latest_begin - kTrendWindow, latest_begin));
+        const int64_t latest_median = Median(vector<int64_t>(latest_begin, durations.end()));
+
+        if (previous_median > 0) {
+            statistics.trend = static_cast<double>(latest_median) / previous_median;
+        }
+    }
+
+    sort(durations.begin(), durations.end());
+
+    statistics.p50 = std::chrono::microseconds(Percentile(durations, 50));
+    statistics.p95 = std::chrono::microseconds(Percentile(durations, 95));
+    statistics.max = std::chrono::microseconds(durations.empty() ? 0 : durations.back());
+
+    return statistics;
+}
@@ -7,6 +7,11 @@
 #include <vector>
 #include <fstream>
 #include <queue>
+#include <algorithm>
+#include <cstdio>
+
+#include <fnmatch.h>
+#include <glob.h>
 
 using namespace std;
 using json = nlohmann::json;
@@ -184,4 +189,82 @@ namespace WebDashUtils {
         return ret;
     }
 
+
+    vector<filesystem::path> ExpandGlob(const string& pattern, const filesystem::path& base_directory) {
+        filesystem::path full_pattern = pattern;
+        if (full_pattern.is_relative()) {
+            full_pattern = base_directory / full_pattern;
+        }
+
+        vector<filesystem::path> matches;
+        const string full_pattern_str = full_pattern.lexically_normal().string();
+        const size_t recursive_position = full_pattern_str.find("**");
+
+        if (recursive_position == string::npos) {
+            glob_t glob_result;
+
+            if (glob(full_pattern_str.c_str(), 0, nullptr, &glob_result) == 0) {
+                for (size_t i = 0; i < glob_result.gl_pathc; ++i) {
+                    matches.emplace_back(glob_result.gl_pathv[i]);
+                }
+            }
+
+            globfree(&glob_result);
+            return matches;
+        }
+
+        /**
+         * Walk everything below the directory in front of the `**` component and match the full paths. Without
+         * FNM_PATHNAME, `*` also matches `/`, so the `**` component matches any depth.
+         */
+
+        const filesystem::path walk_root = GetDirectoryOfFilepath(full_pattern_str.substr(0, recursive_position));
+
+        std::error_code error;
+        if (!filesystem::is_directory(walk_root, error)) {
+            return matches;
+        }
+
+        // `dir/**/x` should also match `dir/x`.
+        string shallow_pattern = full_pattern_str;
+        const size_t double_star_slash = shallow_pattern.find("**/");
+        if (double_star_slash != string::npos) {
+            shallow_pattern.erase(double_star_slash, 3);
+        }
+
+        for (auto it = filesystem::recursive_directory_iterator(walk_root, filesystem::directory_options::skip_permission_denied, error);
+             it != filesystem::recursive_directory_iterator(); it.increment(error)) {
+
+            const string path = it->path().string();
+
+            if (fnmatch(full_pattern_str.c_str(), path.c_str(), 0) == 0 ||
+                    fnmatch(shallow_pattern.c_str(), path.c_str(), 0) == 0) {
+                matches.push_back(it->path());
+            }
+        }
+
+        sort(matches.begin(), matches.end());
+        return matches;
+    }
+
+
+    uint64_t HashFnv1a(string_view data, uint64_t seed) {
+        constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+        uint64_t hash = seed;
+        for (unsigned char c : data) {
+            hash ^= c;
+            hash *= kFnvPrime;
+        }
+
+        return hash;
+    }
+
+
+    string ToHex(uint64_t value) {
+        char buffer[17];
+        snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+        return buffer;
+    }
+
 } // namespace WebDashUtils
@@ -0,0 +1,122 @@
+#include "webdash-worker-pool.hpp"
+
+using namespace std;
+
+
+namespace {
+
+    // Identifies the pool (and the queue within it) that the current thread works for, if any.
+    thread_local const WebDashWorkerPool* tls_current_pool = nullptr;
+    thread_local size_t tls_current_worker_index = 0;
+
+} // namespace
+
+
+WebDashWorkerPool::WebDashWorkerPool(size_t worker_count) {
+    worker_count = max<size_t>(worker_count, 1);
+
+    for (size_t i = 0; i < worker_count; ++i) {
+        _queues.push_back(make_unique<WorkerQueue>());
+    }
+
+    for (size_t i = 0; i < worker_count; ++i) {
+        _threads.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+}
+
+
+WebDashWorkerPool::~WebDashWorkerPool() {
+    {
+        lock_guard<mutex> lock(_wakeup_mutex);
+        _stopping = true;
+    }
+
+    _wakeup.notify_all();
+
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+
+void WebDashWorkerPool::Submit(Job job) {
+    {
+        // The job is published and counted at once: a worker decrements _queued_jobs (under _wakeup_mutex) only
+        // after taking a job, so the count never drops below the number of published jobs.
+        lock_guard<mutex> lock(_wakeup_mutex);
+
+        size_t queue_index;
+
+        if (tls_current_pool == this) {
+            queue_index = tls_current_worker_index;
+        } else {
+            queue_index = _next_external_queue;
+            _next_external_queue = (_next_external_queue + 1) % _queues.size();
+        }
+
+        {
+            lock_guard<mutex> queue_lock(_queues[queue_index]->mutex);
+            _queues[queue_index]->jobs.push_back(std::move(job));
+        }
+
+        _queued_jobs++;
+    }
+
+    _wakeup.notify_one();
+}
+
+
+std::optional<WebDashWorkerPool::Job> WebDashWorkerPool::TakeJob(size_t worker_index) {
+    {
+        auto& own = *_queues[worker_index];
+        lock_guard<mutex> lock(own.mutex);
+
+        if (!own.jobs.empty()) {
+            Job job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            return job;
+        }
+    }
+
+    for (size_t offset = 1; offset < _queues.size(); ++offset) {
+        auto& victim = *_queues[(worker_index + offset) % _queues.size()];
+        lock_guard<mutex> lock(victim.mutex);
+
+        if (!victim.jobs.empty()) {
+            Job job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return job;
+        }
+    }
+
+    return nullopt;
+}
+
+
+void WebDashWorkerPool::WorkerLoop(size_t worker_index) {
+    tls_current_pool = this;
+    tls_current_worker_index = worker_index;
+
+    while (true) {
+        auto job = TakeJob(worker_index);
+
+        if (job) {
+            {
+                lock_guard<mutex> lock(_wakeup_mutex);
+                _queued_jobs--;
+            }
+
+            (*job)();
+            continue;
+        }
+
+        unique_lock<mutex> lock(_wakeup_mutex);
+        _wakeup.wait(lock, [this]() { return _queued_jobs > 0 || _stopping; });
+
+        if (_stopping && _queued_jobs == 0) {
+            break;
+        }
+    }
+
+    tls_current_pool = nullptr;
+}